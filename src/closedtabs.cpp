@@ -0,0 +1,190 @@
+/*****************************************************************************
+ * closedtabs.cpp
+ *****************************************************************************
+ * Copyright (C) 2026 MX Authors
+ *
+ * Authors: Adrian <adrian@mxlinux.org>
+ *          MX Linux <http://mxlinux.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MX Viewer is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MX Viewer.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#include "closedtabs.h"
+
+#include <QCoreApplication>
+#include <QDataStream>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+ClosedTabs::ClosedTabs(QObject *parent)
+    : QObject(parent),
+      fileName(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/closed-tabs")
+{
+    ring.resize(maxEntries);
+    saveTimer.setSingleShot(true);
+    saveTimer.setInterval(2000);
+    connect(&saveTimer, &QTimer::timeout, this, &ClosedTabs::save);
+    load();
+}
+
+ClosedTabs::~ClosedTabs()
+{
+    if (saveTimer.isActive()) {
+        save();
+    }
+}
+
+ClosedTabs *ClosedTabs::instance()
+{
+    static auto *closedTabs = new ClosedTabs(QCoreApplication::instance());
+    return closedTabs;
+}
+
+// Entries are indexed from the oldest.
+ClosedTabs::Entry &ClosedTabs::at(qsizetype index)
+{
+    return ring[(head + index) % maxEntries];
+}
+
+const ClosedTabs::Entry &ClosedTabs::at(qsizetype index) const
+{
+    return ring.at((head + index) % maxEntries);
+}
+
+qsizetype ClosedTabs::size(const Entry &entry)
+{
+    return entry.url.toEncoded().size() + entry.title.size() * 2 + entry.iconRef.size() + entry.history.size();
+}
+
+// A history too big to keep on its own is dropped, the tab then reopens with its page only.
+void ClosedTabs::add(Entry entry)
+{
+    if (size(entry) > maxBytes) {
+        entry.history.clear();
+    }
+    if (count == maxEntries) {
+        removeAt(0);
+    }
+    entry.id = ++lastId;
+    bytes += size(entry);
+    at(count++) = std::move(entry);
+    while (bytes > maxBytes && count > 1) {
+        removeAt(0);
+    }
+    saveTimer.start();
+}
+
+bool ClosedTabs::take(quint64 id, Entry *entry)
+{
+    for (qsizetype i = 0; i < count; ++i) {
+        if (at(i).id == id) {
+            *entry = at(i);
+            removeAt(i);
+            saveTimer.start();
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ClosedTabs::takeLast(Entry *entry)
+{
+    return count > 0 && take(at(count - 1).id, entry);
+}
+
+void ClosedTabs::remove(quint64 id)
+{
+    Entry entry;
+    take(id, &entry);
+}
+
+// Newest first, as they are listed in the menu.
+QList<ClosedTabs::Entry> ClosedTabs::entries() const
+{
+    QList<Entry> result;
+    result.reserve(count);
+    for (qsizetype i = count - 1; i >= 0; --i) {
+        result.append(at(i));
+    }
+    return result;
+}
+
+bool ClosedTabs::isEmpty() const
+{
+    return count == 0;
+}
+
+void ClosedTabs::removeAt(qsizetype index)
+{
+    bytes -= size(at(index));
+    if (index == 0) {
+        at(0) = {};
+        head = (head + 1) % maxEntries;
+    } else {
+        for (qsizetype i = index; i < count - 1; ++i) {
+            at(i) = std::move(at(i + 1));
+        }
+        at(count - 1) = {};
+    }
+    --count;
+}
+
+void ClosedTabs::load()
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_6_0);
+    quint32 version = 0;
+    qint32 entryCount = 0;
+    stream >> version >> entryCount;
+    if (version != fileVersion) {
+        return;
+    }
+    for (qint32 i = 0; i < entryCount && stream.status() == QDataStream::Ok; ++i) {
+        Entry entry;
+        stream >> entry.url >> entry.title >> entry.iconRef >> entry.history;
+        if (stream.status() == QDataStream::Ok) {
+            add(std::move(entry));
+        }
+    }
+    saveTimer.stop();
+}
+
+void ClosedTabs::save()
+{
+    if (!QDir().mkpath(QFileInfo(fileName).path())) {
+        qWarning() << "Could not create data directory for" << fileName;
+        return;
+    }
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return;
+    }
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_6_0);
+    stream << fileVersion << static_cast<qint32>(count);
+    for (qsizetype i = 0; i < count; ++i) {
+        const Entry &entry = at(i);
+        stream << entry.url << entry.title << entry.iconRef << entry.history;
+    }
+    if (!file.commit()) {
+        qWarning() << "Could not save closed tabs";
+    }
+}
@@ -0,0 +1,80 @@
+/*****************************************************************************
+ * closedtabs.h
+ *****************************************************************************
+ * Copyright (C) 2026 MX Authors
+ *
+ * Authors: Adrian <adrian@mxlinux.org>
+ *          MX Linux <http://mxlinux.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MX Viewer is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MX Viewer.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#pragma once
+
+#include <QByteArray>
+#include <QList>
+#include <QObject>
+#include <QString>
+#include <QTimer>
+#include <QUrl>
+
+// Recently closed tabs of all windows, for reopening. A ring of at most
+// maxEntries where the oldest also go once the entries pass maxBytes. Each
+// entry keeps the QWebEngineHistory stream of its tab, so a reopened tab gets
+// back its back and forward list and only loads the current page. Saved to
+// closed-tabs in the data directory a moment after each change.
+class ClosedTabs : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Entry {
+        quint64 id {};
+        QUrl url;
+        QString title;
+        QByteArray iconRef;
+        QByteArray history;
+    };
+
+    static ClosedTabs *instance();
+    ~ClosedTabs() override;
+
+    void add(Entry entry);
+    bool take(quint64 id, Entry *entry);
+    bool takeLast(Entry *entry);
+    void remove(quint64 id);
+    [[nodiscard]] QList<Entry> entries() const;
+    [[nodiscard]] bool isEmpty() const;
+
+private:
+    explicit ClosedTabs(QObject *parent = nullptr);
+
+    QList<Entry> ring;
+    qsizetype head {}; // Oldest entry
+    qsizetype count {};
+    qsizetype bytes {};
+    quint64 lastId {};
+    QString fileName;
+    QTimer saveTimer;
+
+    static constexpr qsizetype maxEntries {25};
+    static constexpr qsizetype maxBytes {1024 * 1024};
+    static constexpr quint32 fileVersion {1};
+
+    [[nodiscard]] Entry &at(qsizetype index);
+    [[nodiscard]] const Entry &at(qsizetype index) const;
+    [[nodiscard]] static qsizetype size(const Entry &entry);
+    void removeAt(qsizetype index);
+    void load();
+    void save();
+};
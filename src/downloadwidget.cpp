@@ -21,6 +21,7 @@
  ****************************************************************************/
 
 #include "downloadwidget.h"
+#include "settings.h"
 #include "ui_downloadwidget.h"
 
 DownloadWidget::DownloadWidget(QWidget* parent)
@@ -58,7 +59,7 @@ void DownloadWidget::downloadRequested(QWebEngineDownloadRequest* download)
 
     progressBar->setProperty("startTime", QDateTime::currentDateTime());
     if (!isVisible()) {
-        restoreGeometry(settings.value("DownloadGeometry").toByteArray());
+        restoreGeometry(Settings::instance()->downloadGeometry());
         show();
     }
     raise();
@@ -166,5 +167,5 @@ void DownloadWidget::updateDownload(QWebEngineDownloadRequest* download, QPushBu
 void DownloadWidget::closeEvent(QCloseEvent* event)
 {
     event->accept();
-    settings.setValue("DownloadGeometry", saveGeometry());
+    Settings::instance()->setDownloadGeometry(saveGeometry());
 }
@@ -45,6 +45,5 @@ protected:
     void closeEvent(QCloseEvent* event) override;
 
 private:
-    QSettings settings;
     Ui::DownloadWidget* ui;
 };
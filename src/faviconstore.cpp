@@ -0,0 +1,288 @@
+/*****************************************************************************
+ * faviconstore.cpp
+ *****************************************************************************
+ * Copyright (C) 2026 MX Authors
+ *
+ * Authors: Adrian <adrian@mxlinux.org>
+ *          MX Linux <http://mxlinux.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MX Viewer is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MX Viewer.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#include "faviconstore.h"
+#include "closedtabs.h"
+#include "settings.h"
+
+#include <QBuffer>
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QPixmap>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QUrl>
+
+#include <limits>
+#include <utility>
+
+FaviconStore::FaviconStore(QObject *parent)
+    : QObject(parent),
+      path(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/favicons")
+{
+    if (!QDir().mkpath(path)) {
+        qWarning() << "Could not create favicon directory" << path;
+    }
+    loadHosts();
+    saveHostsTimer.setSingleShot(true);
+    saveHostsTimer.setInterval(2000);
+    connect(&saveHostsTimer, &QTimer::timeout, this, &FaviconStore::saveHosts);
+}
+
+FaviconStore::~FaviconStore()
+{
+    if (sweeper) {
+        sweeper->wait();
+        delete sweeper;
+    }
+    if (saveHostsTimer.isActive()) {
+        saveHosts();
+    }
+}
+
+FaviconStore *FaviconStore::instance()
+{
+    static auto *store = new FaviconStore(QCoreApplication::instance());
+    return store;
+}
+
+QByteArray FaviconStore::add(const QIcon &icon, const QString &host)
+{
+    if (icon.isNull()) {
+        return {};
+    }
+    const QPixmap pixmap = icon.pixmap(QSize(iconSize, iconSize));
+    QByteArray png;
+    QBuffer buffer(&png);
+    if (!buffer.open(QIODevice::WriteOnly) || !pixmap.save(&buffer, "PNG")) {
+        return {};
+    }
+    const QByteArray ref = addPng(png, host);
+    if (!ref.isEmpty() && !icons.contains(ref)) {
+        icons.insert(ref, icon);
+    }
+    return ref;
+}
+
+QByteArray FaviconStore::addPng(const QByteArray &png, const QString &host)
+{
+    if (png.isEmpty()) {
+        return {};
+    }
+    const QByteArray ref = QCryptographicHash::hash(png, QCryptographicHash::Sha1).toHex();
+    added.insert(ref);
+    if (sweepJob) {
+        QMutexLocker locker(&sweepJob->mutex);
+        sweepJob->keep.insert(ref);
+    }
+    const QString fileName = filePath(ref);
+    if (!QFile::exists(fileName)) {
+        QSaveFile file(fileName);
+        if (!file.open(QIODevice::WriteOnly) || file.write(png) != png.size() || !file.commit()) {
+            qWarning() << "Could not write favicon" << fileName;
+            return {};
+        }
+    }
+    rememberHost(host, ref);
+    return ref;
+}
+
+QIcon FaviconStore::icon(const QByteArray &ref)
+{
+    if (!isReference(ref)) {
+        return {};
+    }
+    auto it = icons.constFind(ref);
+    if (it != icons.constEnd()) {
+        return it.value();
+    }
+    QIcon result;
+    QPixmap pixmap;
+    if (pixmap.load(filePath(ref), "PNG")) {
+        result.addPixmap(pixmap);
+    }
+    icons.insert(ref, result);
+    return result;
+}
+
+QIcon FaviconStore::iconForHost(const QString &host)
+{
+    return icon(hostIcons.value(host));
+}
+
+QByteArray FaviconStore::png(const QByteArray &ref) const
+{
+    if (!isReference(ref)) {
+        return {};
+    }
+    QFile file(filePath(ref));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return {};
+    }
+    return file.readAll();
+}
+
+// References are hex encoded SHA-1 hashes, anything else is legacy inline image data.
+bool FaviconStore::isReference(const QByteArray &value)
+{
+    if (value.size() != 40) {
+        return false;
+    }
+    for (const char c : value) {
+        if (!((c >= '0' && c <= '9') || (c >= 'a' && c <= 'f'))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+QString FaviconStore::filePath(const QByteArray &ref) const
+{
+    return path + '/' + QString::fromLatin1(ref) + ".png";
+}
+
+void FaviconStore::rememberHost(const QString &host, const QByteArray &ref)
+{
+    if (host.isEmpty() || hostIcons.value(host) == ref) {
+        return;
+    }
+    hostIcons.insert(host, ref);
+    saveHostsTimer.start();
+}
+
+void FaviconStore::loadHosts()
+{
+    QFile file(path + "/hosts");
+    if (!file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_6_0);
+    stream >> hostIcons;
+    if (stream.status() != QDataStream::Ok) {
+        hostIcons.clear();
+    }
+}
+
+void FaviconStore::saveHosts()
+{
+    QSaveFile file(path + "/hosts");
+    if (!file.open(QIODevice::WriteOnly)) {
+        return;
+    }
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_6_0);
+    stream << hostIcons;
+    if (!file.commit()) {
+        qWarning() << "Could not save favicon host map";
+    }
+}
+
+// Delete the icon files and forget the hosts that are neither in refs and hosts, the ones history
+// still uses, nor used by bookmarks or recently closed tabs. Clearing history passes nothing and
+// spareRecent false, so the icons seen so far go too.
+void FaviconStore::sweep(const QSet<QByteArray> &refs, const QSet<QString> &hosts, bool spareRecent)
+{
+    QSet<QString> keepHosts = hosts;
+    auto job = std::make_shared<SweepJob>();
+    job->keep = refs;
+    job->spareAfter = spareRecent ? QDateTime::currentMSecsSinceEpoch() - recentMSecs
+                                  : std::numeric_limits<qint64>::max();
+    for (const ClosedTabs::Entry &entry : ClosedTabs::instance()->entries()) {
+        job->keep.insert(entry.iconRef);
+        keepHosts.insert(entry.url.host());
+    }
+    QSettings *settings = Settings::instance()->store();
+    const int count = settings->beginReadArray("Bookmarks");
+    for (int i = 0; i < count; ++i) {
+        settings->setArrayIndex(i);
+        job->keep.insert(settings->value("iconRef").toByteArray());
+        keepHosts.insert(QUrl(settings->value("url").toString()).host());
+    }
+    settings->endArray();
+
+    bool hostsChanged = false;
+    for (auto it = hostIcons.begin(); it != hostIcons.end();) {
+        if (keepHosts.contains(it.key())) {
+            job->keep.insert(it.value());
+            ++it;
+        } else {
+            it = hostIcons.erase(it);
+            hostsChanged = true;
+        }
+    }
+    if (hostsChanged) {
+        saveHostsTimer.start();
+    }
+    if (!spareRecent) {
+        added.clear();
+    }
+    if (sweeper) {
+        queuedSweep = job;
+        return;
+    }
+    startSweep(job);
+}
+
+void FaviconStore::startSweep(const std::shared_ptr<SweepJob> &job)
+{
+    job->keep.unite(added);
+    sweepJob = job;
+    sweeper = QThread::create([job, path = path] {
+        QDirIterator it(path, {"*.png"}, QDir::Files);
+        while (it.hasNext()) {
+            it.next();
+            const QFileInfo info = it.fileInfo();
+            const QByteArray ref = info.completeBaseName().toLatin1();
+            if (!isReference(ref) || info.lastModified().toMSecsSinceEpoch() > job->spareAfter) {
+                continue;
+            }
+            QMutexLocker locker(&job->mutex);
+            if (!job->keep.contains(ref) && QFile::remove(info.filePath())) {
+                job->removed.append(ref);
+            }
+        }
+    });
+    connect(sweeper, &QThread::finished, this, &FaviconStore::finishSweep);
+    sweeper->start(QThread::LowPriority);
+}
+
+void FaviconStore::finishSweep()
+{
+    sweeper->deleteLater();
+    sweeper = nullptr;
+    const std::shared_ptr<SweepJob> job = std::move(sweepJob);
+    for (const QByteArray &ref : std::as_const(job->removed)) {
+        icons.remove(ref);
+    }
+    if (queuedSweep) {
+        startSweep(std::exchange(queuedSweep, {}));
+    } else {
+        added.clear();
+    }
+}
@@ -0,0 +1,90 @@
+/*****************************************************************************
+ * faviconstore.h
+ *****************************************************************************
+ * Copyright (C) 2026 MX Authors
+ *
+ * Authors: Adrian <adrian@mxlinux.org>
+ *          MX Linux <http://mxlinux.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MX Viewer is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MX Viewer.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#pragma once
+
+#include <QByteArray>
+#include <QHash>
+#include <QIcon>
+#include <QMutex>
+#include <QObject>
+#include <QSet>
+#include <QString>
+#include <QThread>
+#include <QTimer>
+
+#include <memory>
+
+// Favicons are stored once on disk as PNG files named after the hash of their
+// content, and decoded at most once per run. History entries and bookmarks only
+// keep the hash ("icon reference"). The last icon seen for every host is also
+// remembered so tabs can show an icon before their page has loaded. Icons and
+// hosts nothing refers to any more are dropped by sweep(), which the history
+// calls when it is cleared and some time after entries were deleted.
+class FaviconStore : public QObject
+{
+    Q_OBJECT
+
+public:
+    static FaviconStore *instance();
+    ~FaviconStore() override;
+
+    QByteArray add(const QIcon &icon, const QString &host = {});
+    QByteArray addPng(const QByteArray &png, const QString &host = {});
+
+    [[nodiscard]] QIcon icon(const QByteArray &ref);
+    [[nodiscard]] QIcon iconForHost(const QString &host);
+    [[nodiscard]] QByteArray png(const QByteArray &ref) const;
+    [[nodiscard]] static bool isReference(const QByteArray &value);
+
+    void sweep(const QSet<QByteArray> &refs, const QSet<QString> &hosts, bool spareRecent);
+
+private:
+    explicit FaviconStore(QObject *parent = nullptr);
+
+    QString path;
+    QHash<QByteArray, QIcon> icons;
+    QHash<QString, QByteArray> hostIcons;
+    QTimer saveHostsTimer;
+
+    // Files are deleted on a worker thread; icons added meanwhile are put in keep, under the mutex.
+    struct SweepJob {
+        QMutex mutex;
+        QSet<QByteArray> keep;
+        qint64 spareAfter {};
+        QList<QByteArray> removed;
+    };
+    QSet<QByteArray> added; // Since the last sweep, possibly for entries not written yet
+    std::shared_ptr<SweepJob> sweepJob;
+    std::shared_ptr<SweepJob> queuedSweep;
+    QThread *sweeper {};
+
+    static constexpr int iconSize {32};
+    // Spared by sweeps after deletions: another process may not have written the entry yet.
+    static constexpr qint64 recentMSecs {10 * 60 * 1000};
+
+    [[nodiscard]] QString filePath(const QByteArray &ref) const;
+    void rememberHost(const QString &host, const QByteArray &ref);
+    void loadHosts();
+    void saveHosts();
+    void startSweep(const std::shared_ptr<SweepJob> &job);
+    void finishSweep();
+};
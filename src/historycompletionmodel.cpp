@@ -0,0 +1,306 @@
+/*****************************************************************************
+ * historycompletionmodel.cpp
+ *****************************************************************************
+ * Copyright (C) 2026 MX Authors
+ *
+ * Authors: Adrian <adrian@mxlinux.org>
+ *          MX Linux <http://mxlinux.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MX Viewer is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MX Viewer.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#include "historycompletionmodel.h"
+
+#include <QCoreApplication>
+#include <QUrl>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+QStringList hostsOf(const QString &url)
+{
+    const QString host = QUrl(url).host();
+    if (host.isEmpty()) {
+        return {};
+    }
+    if (host.startsWith("www.", Qt::CaseInsensitive)) {
+        return {host, host.mid(4)};
+    }
+    return {host};
+}
+} // namespace
+
+HistoryCompletionModel::HistoryCompletionModel(QObject *parent)
+    : QAbstractListModel(parent)
+{
+    auto *store = HistoryStore::instance();
+    connect(store, &HistoryStore::entryAdded, this, &HistoryCompletionModel::entryAdded);
+    connect(store, &HistoryStore::entryVisited, this, &HistoryCompletionModel::entryVisited);
+    connect(store, &HistoryStore::visitsRemoved, this, &HistoryCompletionModel::visitsRemoved);
+    connect(store, &HistoryStore::entryRemoved, this, &HistoryCompletionModel::entryRemoved);
+    connect(store, &HistoryStore::cleared, this, &HistoryCompletionModel::cleared);
+    load();
+}
+
+HistoryCompletionModel::~HistoryCompletionModel()
+{
+    if (loader) {
+        loader->wait();
+        delete loader;
+    }
+}
+
+HistoryCompletionModel *HistoryCompletionModel::instance()
+{
+    static auto *model = new HistoryCompletionModel(QCoreApplication::instance());
+    return model;
+}
+
+int HistoryCompletionModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : static_cast<int>(model.urls.size());
+}
+
+QVariant HistoryCompletionModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= model.urls.size() || (role != Qt::DisplayRole && role != Qt::EditRole)) {
+        return {};
+    }
+    return model.urls.at(model.urls.size() - 1 - index.row());
+}
+
+// Most frecent host starting with prefix, if any.
+QString HistoryCompletionModel::completeHost(const QString &prefix) const
+{
+    return model.hosts.complete(prefix);
+}
+
+bool HistoryCompletionModel::isCompletable(const QString &url)
+{
+    return !url.isEmpty() && url != "about:blank" && !url.startsWith("mx-history:") && !url.startsWith("mx-settings:")
+           && !url.startsWith("mx-tasks:");
+}
+
+// Log of the summed visit weights. Visits that fell out of the bounded list are counted at the first visit.
+double HistoryCompletionModel::frecency(const HistoryEntry &entry)
+{
+    double score = -std::numeric_limits<double>::infinity();
+    const auto add = [&score](double weight) {
+        const double high = std::max(score, weight);
+        score = high + std::log1p(std::exp(std::min(score, weight) - high));
+    };
+    for (const qint64 visit : entry.visits) {
+        add(static_cast<double>(visit) / decayMSecs);
+    }
+    const qint64 older = entry.visitCount - entry.visits.size();
+    if (older > 0 || entry.visits.isEmpty()) {
+        const qint64 first = entry.firstVisit > 0 ? entry.firstVisit : entry.lastVisit;
+        add(static_cast<double>(first) / decayMSecs + std::log(static_cast<double>(std::max<qint64>(older, 1))));
+    }
+    return score;
+}
+
+// Read the whole history once, in the background. Changes made meanwhile are queued and replayed.
+void HistoryCompletionModel::load()
+{
+    auto job = std::make_shared<LoadJob>();
+    loadJob = job;
+    const HistoryStore::Snapshot snapshot = HistoryStore::instance()->snapshot();
+    loader = QThread::create([job, snapshot] {
+        QList<HistoryEntry> entries;
+        HistoryStore::forEachEntry(snapshot, [&entries](const HistoryEntry &entry) {
+            if (isCompletable(entry.url)) {
+                entries.append(entry);
+            }
+        });
+        std::sort(entries.begin(), entries.end(), [](const HistoryEntry &a, const HistoryEntry &b) {
+            return a.lastVisit != b.lastVisit ? a.lastVisit < b.lastVisit : a.id < b.id;
+        });
+        Data &data = job->data;
+        for (const HistoryEntry &entry : std::as_const(entries)) {
+            const qsizetype index = data.urlCounts.value(entry.url) > 0 ? data.urls.lastIndexOf(entry.url) : -1;
+            if (index >= 0) {
+                data.urls.removeAt(index);
+            }
+            ++data.urlCounts[entry.url];
+            data.urls.append(entry.url);
+            const double score = frecency(entry);
+            for (const QString &host : hostsOf(entry.url)) {
+                data.hosts.add(host, score);
+            }
+        }
+    });
+    connect(loader, &QThread::finished, this, [this] {
+        loader->deleteLater();
+        loader = nullptr;
+        finishLoad();
+    });
+    loader->start(QThread::LowPriority);
+}
+
+void HistoryCompletionModel::finishLoad()
+{
+    const std::shared_ptr<LoadJob> job = std::move(loadJob);
+    if (!job) {
+        return;
+    }
+    beginResetModel();
+    model = std::move(job->data);
+    endResetModel();
+    for (const PendingChange &change : std::as_const(pending)) {
+        apply(change);
+    }
+    pending.clear();
+}
+
+void HistoryCompletionModel::apply(const PendingChange &change)
+{
+    const HistoryEntry &entry = change.entry;
+    switch (change.type) {
+    case ChangeType::Added: {
+        addUrl(entry.url);
+        const double score = frecency(entry);
+        for (const QString &host : hostsOf(entry.url)) {
+            model.hosts.add(host, score);
+        }
+        break;
+    }
+    case ChangeType::Visited:
+        moveToTop(entry.url);
+        for (const QString &host : hostsOf(entry.url)) {
+            model.hosts.boost(host, static_cast<double>(entry.lastVisit) / decayMSecs);
+        }
+        break;
+    case ChangeType::VisitsRemoved: {
+        // The row stays where it is, the hosts lose the weight of the removed visits.
+        const double before = frecency(change.previous);
+        const double after = frecency(entry);
+        for (const QString &host : hostsOf(entry.url)) {
+            model.hosts.remove(host, before);
+            model.hosts.add(host, after);
+        }
+        break;
+    }
+    case ChangeType::Removed: {
+        removeUrl(entry.url);
+        const double score = frecency(entry);
+        for (const QString &host : hostsOf(entry.url)) {
+            model.hosts.remove(host, score);
+        }
+        break;
+    }
+    }
+}
+
+// Make url the first row, unless it is not a row at all.
+void HistoryCompletionModel::moveToTop(const QString &url)
+{
+    const qsizetype index = model.urlCounts.value(url) > 0 ? model.urls.lastIndexOf(url) : -1;
+    if (index < 0 || index == model.urls.size() - 1) {
+        return;
+    }
+    const int row = static_cast<int>(model.urls.size() - 1 - index);
+    beginMoveRows({}, row, row, {}, 0);
+    model.urls.removeAt(index);
+    model.urls.append(url);
+    endMoveRows();
+}
+
+void HistoryCompletionModel::addUrl(const QString &url)
+{
+    if (model.urlCounts.value(url) > 0) {
+        ++model.urlCounts[url];
+        moveToTop(url);
+        return;
+    }
+    beginInsertRows({}, 0, 0);
+    model.urlCounts.insert(url, 1);
+    model.urls.append(url);
+    endInsertRows();
+}
+
+void HistoryCompletionModel::removeUrl(const QString &url)
+{
+    auto it = model.urlCounts.find(url);
+    if (it == model.urlCounts.end()) {
+        return;
+    }
+    if (--it.value() <= 0) {
+        model.urlCounts.erase(it);
+        const qsizetype index = model.urls.lastIndexOf(url);
+        const int row = static_cast<int>(model.urls.size() - 1 - index);
+        beginRemoveRows({}, row, row);
+        model.urls.removeAt(index);
+        endRemoveRows();
+    }
+}
+
+void HistoryCompletionModel::entryAdded(const HistoryEntry &entry)
+{
+    if (!isCompletable(entry.url)) {
+        return;
+    }
+    if (loadJob) {
+        pending.append({ChangeType::Added, entry, {}});
+    } else {
+        apply({ChangeType::Added, entry, {}});
+    }
+}
+
+void HistoryCompletionModel::entryVisited(const HistoryEntry &entry)
+{
+    if (!isCompletable(entry.url)) {
+        return;
+    }
+    if (loadJob) {
+        pending.append({ChangeType::Visited, entry, {}});
+    } else {
+        apply({ChangeType::Visited, entry, {}});
+    }
+}
+
+void HistoryCompletionModel::visitsRemoved(const HistoryEntry &before, const HistoryEntry &after)
+{
+    if (!isCompletable(after.url)) {
+        return;
+    }
+    if (loadJob) {
+        pending.append({ChangeType::VisitsRemoved, after, before});
+    } else {
+        apply({ChangeType::VisitsRemoved, after, before});
+    }
+}
+
+void HistoryCompletionModel::entryRemoved(const HistoryEntry &entry)
+{
+    if (!isCompletable(entry.url)) {
+        return;
+    }
+    if (loadJob) {
+        pending.append({ChangeType::Removed, entry, {}});
+    } else {
+        apply({ChangeType::Removed, entry, {}});
+    }
+}
+
+// A load in flight describes the old history and is dropped.
+void HistoryCompletionModel::cleared()
+{
+    loadJob.reset();
+    pending.clear();
+    beginResetModel();
+    model = {};
+    endResetModel();
+}
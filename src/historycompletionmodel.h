@@ -0,0 +1,94 @@
+/*****************************************************************************
+ * historycompletionmodel.h
+ *****************************************************************************
+ * Copyright (C) 2026 MX Authors
+ *
+ * Authors: Adrian <adrian@mxlinux.org>
+ *          MX Linux <http://mxlinux.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MX Viewer is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MX Viewer.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#pragma once
+
+#include "historystore.h"
+#include "hosttrie.h"
+
+#include <QAbstractListModel>
+#include <QHash>
+#include <QList>
+#include <QPointer>
+#include <QStringList>
+#include <QThread>
+
+#include <memory>
+
+// History URLs for the address bar completer, most recently visited first,
+// plus a frecency ranked trie of the visited hosts for inline completion.
+// Loaded once on a worker thread and then updated row by row as visits are
+// recorded or deleted, so it can be shared by every window and never needs
+// refreshing.
+class HistoryCompletionModel : public QAbstractListModel
+{
+    Q_OBJECT
+
+public:
+    static HistoryCompletionModel *instance();
+    ~HistoryCompletionModel() override;
+
+    [[nodiscard]] int rowCount(const QModelIndex &parent = {}) const override;
+    [[nodiscard]] QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+
+    [[nodiscard]] QString completeHost(const QString &prefix) const;
+
+private:
+    explicit HistoryCompletionModel(QObject *parent = nullptr);
+
+    // URLs are kept oldest first so a new visit is an append; rows are presented in reverse.
+    struct Data {
+        QStringList urls;
+        QHash<QString, int> urlCounts;
+        HostTrie hosts;
+    };
+    struct LoadJob {
+        Data data;
+    };
+    enum class ChangeType { Added, Visited, VisitsRemoved, Removed };
+    struct PendingChange {
+        ChangeType type {};
+        HistoryEntry entry;
+        HistoryEntry previous; // For VisitsRemoved
+    };
+
+    Data model;
+    std::shared_ptr<LoadJob> loadJob;
+    QList<PendingChange> pending;
+    QPointer<QThread> loader;
+
+    // A visit weighs e times less than one a week later.
+    static constexpr double decayMSecs {7.0 * 24 * 60 * 60 * 1000};
+
+    static bool isCompletable(const QString &url);
+    static double frecency(const HistoryEntry &entry);
+    void load();
+    void finishLoad();
+    void apply(const PendingChange &change);
+    void moveToTop(const QString &url);
+    void addUrl(const QString &url);
+    void removeUrl(const QString &url);
+    void entryAdded(const HistoryEntry &entry);
+    void entryVisited(const HistoryEntry &entry);
+    void visitsRemoved(const HistoryEntry &before, const HistoryEntry &after);
+    void entryRemoved(const HistoryEntry &entry);
+    void cleared();
+};
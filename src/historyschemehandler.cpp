@@ -0,0 +1,469 @@
+/*****************************************************************************
+ * historyschemehandler.cpp
+ *****************************************************************************
+ * Copyright (C) 2026 MX Authors
+ *
+ * Authors: Adrian <adrian@mxlinux.org>
+ *          MX Linux <http://mxlinux.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MX Viewer is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MX Viewer.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#include "historyschemehandler.h"
+#include "faviconstore.h"
+#include "historysearchindex.h"
+#include "historystore.h"
+
+#include <QBuffer>
+#include <QCoreApplication>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QPointer>
+#include <QUrlQuery>
+#include <QWebEngineUrlRequestJob>
+#include <QWebEngineUrlScheme>
+
+#include <limits>
+#include <memory>
+
+HistorySchemeHandler::HistorySchemeHandler(QObject *parent)
+    : QWebEngineUrlSchemeHandler(parent)
+{
+}
+
+// Must be called before the QApplication is created.
+void HistorySchemeHandler::registerScheme()
+{
+    QWebEngineUrlScheme scheme("mx-history");
+    scheme.setSyntax(QWebEngineUrlScheme::Syntax::Host);
+    scheme.setFlags(QWebEngineUrlScheme::SecureScheme | QWebEngineUrlScheme::LocalScheme
+                    | QWebEngineUrlScheme::LocalAccessAllowed);
+    QWebEngineUrlScheme::registerScheme(scheme);
+}
+
+void HistorySchemeHandler::requestStarted(QWebEngineUrlRequestJob *job)
+{
+    const QUrl url = job->requestUrl();
+    if (url.host() != "list") {
+        job->fail(QWebEngineUrlRequestJob::UrlNotFound);
+        return;
+    }
+    const QString path = url.path();
+    // Only the page itself may be opened from elsewhere.
+    if (!path.isEmpty() && path != "/" && !isOwnRequest(job)) {
+        job->fail(QWebEngineUrlRequestJob::RequestDenied);
+        return;
+    }
+    const QUrlQuery query(url);
+    if (path.isEmpty() || path == "/") {
+        HistorySearchIndex::instance()->prepare();
+        reply(job, "text/html", pageHtml());
+    } else if (path == "/entries") {
+        reply(job, "application/json", entriesJson(query));
+    } else if (path.startsWith("/icon/")) {
+        const QByteArray png = FaviconStore::instance()->png(path.mid(6).toLatin1());
+        if (png.isEmpty()) {
+            job->fail(QWebEngineUrlRequestJob::UrlNotFound);
+            return;
+        }
+#if QT_VERSION >= QT_VERSION_CHECK(6, 6, 0)
+        // Icons are addressed by content hash so they never change
+        job->setAdditionalResponseHeaders({{"Cache-Control", "max-age=31536000, immutable"}});
+#endif
+        reply(job, "image/png", png);
+    } else if (path == "/delete" && job->requestMethod() == "POST") {
+        bool ok = false;
+        const int id = query.queryItemValue("id").toInt(&ok);
+        const bool removed = ok && HistoryStore::instance()->remove(id);
+        reply(job, "application/json", QJsonDocument(QJsonObject {{"ok", removed}}).toJson(QJsonDocument::Compact));
+    } else if (path == "/clear" && job->requestMethod() == "POST") {
+        clearRange(job, query);
+    } else {
+        job->fail(QWebEngineUrlRequestJob::UrlNotFound);
+    }
+}
+
+// Without "from" and "to" everything is cleared. A range is removed in the background and the
+// request is answered once it is done, so the page reloads the list only then.
+void HistorySchemeHandler::clearRange(QWebEngineUrlRequestJob *job, const QUrlQuery &query)
+{
+    auto *store = HistoryStore::instance();
+    const QByteArray ok = QJsonDocument(QJsonObject {{"ok", true}}).toJson(QJsonDocument::Compact);
+    bool fromOk = false;
+    bool toOk = false;
+    const qint64 from = query.queryItemValue("from").toLongLong(&fromOk);
+    const qint64 to = query.queryItemValue("to").toLongLong(&toOk);
+    if (!fromOk || !toOk) {
+        store->clear();
+        reply(job, "application/json", ok);
+        return;
+    }
+    QPointer<QWebEngineUrlRequestJob> pendingJob(job);
+    auto connection = std::make_shared<QMetaObject::Connection>();
+    *connection = connect(store, &HistoryStore::rangeRemoved, this,
+                          [pendingJob, connection, from, to, ok](qint64 removedFrom, qint64 removedTo) {
+                              if (removedFrom != from || removedTo != to) {
+                                  return;
+                              }
+                              QObject::disconnect(*connection);
+                              if (pendingJob) {
+                                  reply(pendingJob, "application/json", ok);
+                              }
+                          });
+    store->removeRange(from, to);
+}
+
+// Made by the page of this scheme, not by another page or site posting to it.
+bool HistorySchemeHandler::isOwnRequest(const QWebEngineUrlRequestJob *job)
+{
+    const QUrl initiator = job->initiator();
+    return initiator.scheme() == "mx-history" && initiator.host() == "list";
+}
+
+void HistorySchemeHandler::reply(QWebEngineUrlRequestJob *job, const QByteArray &contentType, const QByteArray &data)
+{
+    auto *buffer = new QBuffer(job);
+    buffer->setData(data);
+    buffer->open(QIODevice::ReadOnly);
+    job->reply(contentType, buffer);
+}
+
+// Return a page of up to "limit" entries starting at "cursor". Without a query entries are listed
+// by last visit, newest first, and the cursor is the "lastVisit.id" of the entry to continue below;
+// with "q" they are the ranked search results and the cursor is a position in them. The cursor is
+// opaque to the page. "from" and "to" limit either to entries last visited in that time range.
+// "next" is null once there is nothing more.
+QByteArray HistorySchemeHandler::entriesJson(const QUrlQuery &query)
+{
+    const auto *store = HistoryStore::instance();
+    const QString cursor = query.queryItemValue("cursor");
+    bool ok = false;
+    int limit = query.queryItemValue("limit").toInt(&ok);
+    if (!ok || limit <= 0) {
+        limit = defaultPageSize;
+    }
+    limit = qMin(limit, maxPageSize);
+    const QString term = query.queryItemValue("q", QUrl::FullyDecoded).trimmed();
+    qint64 from = query.queryItemValue("from").toLongLong(&ok);
+    if (!ok) {
+        from = std::numeric_limits<qint64>::min();
+    }
+    qint64 to = query.queryItemValue("to").toLongLong(&ok);
+    if (!ok) {
+        to = std::numeric_limits<qint64>::max();
+    }
+
+    QJsonArray entries;
+    const auto add = [&entries](const HistoryEntry &entry) {
+        entries.append(QJsonObject {
+            {"id", entry.id},
+            {"title", entry.title.isEmpty() ? entry.url : entry.title},
+            {"url", entry.url},
+            {"icon", FaviconStore::isReference(entry.iconRef)
+                         ? "mx-history://list/icon/" + QString::fromLatin1(entry.iconRef)
+                         : QString()},
+            {"visitCount", entry.visitCount},
+            {"lastVisit", static_cast<double>(entry.lastVisit)},
+        });
+    };
+    QJsonValue next(QJsonValue::Null);
+    if (term.isEmpty()) {
+        HistoryStore::Position position {to, std::numeric_limits<int>::min()};
+        const QStringList parts = cursor.split('.');
+        if (parts.size() == 2) {
+            bool visitOk = false;
+            bool idOk = false;
+            const qint64 lastVisit = parts.at(0).toLongLong(&visitOk);
+            const int id = parts.at(1).toInt(&idOk);
+            if (visitOk && idOk) {
+                position = {lastVisit, id};
+            }
+        }
+        const QList<int> ids = store->recentIds(position, limit, from);
+        for (const int id : ids) {
+            const HistoryEntry entry = store->entry(id);
+            if (entry.isValid()) {
+                add(entry);
+            }
+        }
+        if (ids.size() == limit) {
+            const HistoryStore::Position last = store->position(ids.constLast());
+            next = QString::number(last.lastVisit) + '.' + QString::number(last.id);
+        }
+    } else {
+        const QList<int> ids = HistorySearchIndex::instance()->search(term);
+        qsizetype position = qMax(cursor.toInt(), 0);
+        for (; position < ids.size() && entries.size() < limit; ++position) {
+            const qint64 lastVisit = store->position(ids.at(position)).lastVisit;
+            if (lastVisit < from || lastVisit >= to) {
+                continue;
+            }
+            const HistoryEntry entry = store->entry(ids.at(position));
+            if (entry.isValid()) {
+                add(entry);
+            }
+        }
+        if (position < ids.size()) {
+            next = QString::number(position);
+        }
+    }
+    const QJsonObject result {{"entries", entries}, {"next", next}};
+    return QJsonDocument(result).toJson(QJsonDocument::Compact);
+}
+
+// Strings keep the MainWindow context so existing translations of the history page still apply
+QByteArray HistorySchemeHandler::pageHtml()
+{
+    const QJsonObject strings {
+        {"delete", QCoreApplication::translate("MainWindow", "Delete")},
+        {"confirmClear", QCoreApplication::translate("MainWindow", "Clear all history entries?")},
+        {"visits", QCoreApplication::translate("MainWindow", "Visits: %1")},
+        {"confirmClearRange", QCoreApplication::translate("MainWindow", "Clear history for the selected time range?")},
+        {"earlier", QCoreApplication::translate("MainWindow", "Earlier")},
+        {"all", QCoreApplication::translate("MainWindow", "All time")},
+        {"hour", QCoreApplication::translate("MainWindow", "Last hour")},
+        {"today", QCoreApplication::translate("MainWindow", "Today")},
+        {"week", QCoreApplication::translate("MainWindow", "Last 7 days")},
+        {"month", QCoreApplication::translate("MainWindow", "Last 30 days")},
+    };
+    const QString html = QStringLiteral(R"(<!doctype html>
+<html>
+<head>
+  <meta charset="utf-8">
+  <title>%1</title>
+  <style>
+    :root { color-scheme: light; }
+    body { font-family: sans-serif; margin: 24px; color: #1f2328; background: #ffffff; }
+    h1 { font-size: 22px; margin: 0 0 12px; }
+    .controls { display: flex; gap: 12px; align-items: center; margin-bottom: 16px; flex-wrap: wrap; }
+    .search { flex: 1 1 240px; padding: 8px 10px; border: 1px solid #d0d7de; border-radius: 6px; }
+    .range { padding: 8px 10px; border: 1px solid #d0d7de; border-radius: 6px; background: #fff; }
+    .clear { padding: 8px 12px; border: 1px solid #d0d7de; background: #f6f8fa; border-radius: 6px; cursor: pointer; }
+    .list { list-style: none; padding: 0; margin: 0; display: flex; flex-direction: column; gap: 10px; }
+    .entry { display: grid; grid-template-columns: 24px 1fr; gap: 10px; padding: 10px 12px; border: 1px solid #eaeef2; border-radius: 8px; }
+    .icon { width: 20px; height: 20px; border-radius: 4px; }
+    .icon.placeholder { background: #eaeef2; }
+    .content { display: flex; flex-direction: column; gap: 4px; }
+    .row { display: flex; align-items: center; gap: 10px; }
+    .title { color: #0969da; text-decoration: none; font-weight: 600; flex: 1 1 auto; }
+    .url { color: #57606a; font-size: 12px; word-break: break-all; }
+    .visits { color: #57606a; font-size: 12px; }
+    .delete { padding: 4px 8px; border: 1px solid #d0d7de; background: #fff; border-radius: 6px; cursor: pointer; }
+    .day { font-weight: 600; color: #57606a; margin-top: 8px; }
+    .empty { padding: 16px; border: 1px dashed #d0d7de; border-radius: 8px; color: #57606a; }
+    #more { height: 1px; }
+  </style>
+</head>
+<body>
+  <h1>%1</h1>
+  <div class="controls">
+    <input id="search" class="search" type="search" placeholder="%2" autofocus>
+    <select id="range" class="range"></select>
+    <button id="clear" class="clear">%3</button>
+  </div>
+  <ul id="list" class="list"></ul>
+  <div id="empty" class="empty" hidden>%4</div>
+  <div id="more"></div>
+  <script>
+    const strings = %5;
+    const pageSize = %6;
+    const list = document.getElementById('list');
+    const empty = document.getElementById('empty');
+    const more = document.getElementById('more');
+    const search = document.getElementById('search');
+    const range = document.getElementById('range');
+    ['all', 'hour', 'today', 'week', 'month'].forEach(key => range.add(new Option(strings[key], key)));
+    let cursor = null;
+    let lastDay = null;
+    let loading = false;
+    let exhausted = false;
+    let generation = 0;
+
+    function request(method, url) {
+      return new Promise((resolve, reject) => {
+        const xhr = new XMLHttpRequest();
+        xhr.open(method, url);
+        xhr.responseType = 'json';
+        xhr.onload = () => resolve(xhr.response);
+        xhr.onerror = reject;
+        xhr.send();
+      });
+    }
+    function queryString(params) {
+      return Object.entries(params).map(([key, value]) => key + '=' + encodeURIComponent(value)).join('&');
+    }
+    // Time range of the selected period; "to" is left open so new visits show up.
+    function rangeBounds() {
+      const now = Date.now();
+      const day = 24 * 60 * 60 * 1000;
+      switch (range.value) {
+      case 'hour':
+        return { from: now - 60 * 60 * 1000 };
+      case 'today':
+        return { from: new Date().setHours(0, 0, 0, 0) };
+      case 'week':
+        return { from: now - 7 * day };
+      case 'month':
+        return { from: now - 30 * day };
+      }
+      return {};
+    }
+    // Entries are listed by last visit, so a heading goes before the first entry of every day.
+    function dayHeading(entry) {
+      const day = entry.lastVisit > 0 ? new Date(entry.lastVisit).toLocaleDateString() : strings.earlier;
+      if (day === lastDay) {
+        return null;
+      }
+      lastDay = day;
+      const li = document.createElement('li');
+      li.className = 'day';
+      li.textContent = day;
+      return li;
+    }
+    function createRow(entry) {
+      const li = document.createElement('li');
+      li.className = 'entry';
+      let icon;
+      if (entry.icon) {
+        icon = document.createElement('img');
+        icon.className = 'icon';
+        icon.alt = '';
+        icon.src = entry.icon;
+      } else {
+        icon = document.createElement('span');
+        icon.className = 'icon placeholder';
+      }
+      const content = document.createElement('div');
+      content.className = 'content';
+      const row = document.createElement('div');
+      row.className = 'row';
+      const title = document.createElement('a');
+      title.className = 'title';
+      title.href = entry.url;
+      title.textContent = entry.title;
+      const del = document.createElement('button');
+      del.className = 'delete';
+      del.textContent = strings.delete;
+      del.addEventListener('click', event => {
+        event.preventDefault();
+        request('POST', 'mx-history://list/delete?id=' + entry.id);
+        li.remove();
+        updateEmpty();
+      });
+      const url = document.createElement('div');
+      url.className = 'url';
+      url.textContent = entry.url;
+      const visits = document.createElement('div');
+      visits.className = 'visits';
+      visits.textContent = strings.visits.replace('%1', entry.visitCount) + ' \u00b7 '
+          + new Date(entry.lastVisit).toLocaleString();
+      row.append(title, del);
+      content.append(row, url, visits);
+      li.append(icon, content);
+      return li;
+    }
+    function updateEmpty() {
+      empty.hidden = !exhausted || list.querySelector('.entry') !== null;
+    }
+    function nearEnd() {
+      return more.getBoundingClientRect().top < window.innerHeight * 2;
+    }
+    async function loadMore() {
+      if (loading || exhausted) {
+        return;
+      }
+      loading = true;
+      const current = generation;
+      const params = Object.assign({ limit: pageSize }, rangeBounds());
+      if (cursor !== null) {
+        params.cursor = cursor;
+      }
+      const term = search.value.trim();
+      if (term) {
+        params.q = term;
+      }
+      try {
+        const data = await request('GET', 'mx-history://list/entries?' + queryString(params));
+        if (current !== generation) {
+          return;
+        }
+        const fragment = document.createDocumentFragment();
+        data.entries.forEach(entry => {
+          const heading = term ? null : dayHeading(entry);
+          if (heading) {
+            fragment.appendChild(heading);
+          }
+          fragment.appendChild(createRow(entry));
+        });
+        list.appendChild(fragment);
+        cursor = data.next;
+        exhausted = data.next === null;
+      } finally {
+        if (current === generation) {
+          loading = false;
+          updateEmpty();
+          if (!exhausted && nearEnd()) {
+            loadMore();
+          }
+        }
+      }
+    }
+    function reset() {
+      generation++;
+      loading = false;
+      exhausted = false;
+      cursor = null;
+      lastDay = null;
+      list.replaceChildren();
+      empty.hidden = true;
+      loadMore();
+    }
+    new IntersectionObserver(entries => {
+      if (entries.some(entry => entry.isIntersecting)) {
+        loadMore();
+      }
+    }, { rootMargin: '400px' }).observe(more);
+    let searchTimer = 0;
+    search.addEventListener('input', () => {
+      clearTimeout(searchTimer);
+      searchTimer = setTimeout(reset, 150);
+    });
+    range.addEventListener('change', reset);
+    // Clears the selected period only.
+    document.getElementById('clear').addEventListener('click', async event => {
+      event.preventDefault();
+      const bounds = rangeBounds();
+      if (bounds.from === undefined) {
+        if (confirm(strings.confirmClear)) {
+          await request('POST', 'mx-history://list/clear');
+          reset();
+        }
+      } else if (confirm(strings.confirmClearRange)) {
+        bounds.to = Date.now() + 1;
+        await request('POST', 'mx-history://list/clear?' + queryString(bounds));
+        reset();
+      }
+    });
+    loadMore();
+  </script>
+</body>
+</html>)")
+                             .arg(QCoreApplication::translate("MainWindow", "History").toHtmlEscaped(),
+                                  QCoreApplication::translate("MainWindow", "Search history").toHtmlEscaped(),
+                                  QCoreApplication::translate("MainWindow", "Clear history").toHtmlEscaped(),
+                                  QCoreApplication::translate("MainWindow", "No history entries.").toHtmlEscaped(),
+                                  QString::fromUtf8(QJsonDocument(strings).toJson(QJsonDocument::Compact)),
+                                  QString::number(defaultPageSize));
+    return html.toUtf8();
+}
@@ -0,0 +1,52 @@
+/*****************************************************************************
+ * historyschemehandler.h
+ *****************************************************************************
+ * Copyright (C) 2026 MX Authors
+ *
+ * Authors: Adrian <adrian@mxlinux.org>
+ *          MX Linux <http://mxlinux.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MX Viewer is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MX Viewer.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#pragma once
+
+#include <QWebEngineUrlSchemeHandler>
+
+class QUrlQuery;
+class QWebEngineUrlRequestJob;
+
+// Serves the history page. mx-history://list returns a small page shell that
+// pulls entries a page at a time from mx-history://list/entries and loads
+// favicons from mx-history://list/icon/<ref>, so opening it does not depend on
+// the size of the history.
+class HistorySchemeHandler : public QWebEngineUrlSchemeHandler
+{
+    Q_OBJECT
+
+public:
+    explicit HistorySchemeHandler(QObject *parent = nullptr);
+
+    static void registerScheme();
+    void requestStarted(QWebEngineUrlRequestJob *job) override;
+
+private:
+    static constexpr int defaultPageSize {100};
+    static constexpr int maxPageSize {500};
+
+    static QByteArray pageHtml();
+    static QByteArray entriesJson(const QUrlQuery &query);
+    void clearRange(QWebEngineUrlRequestJob *job, const QUrlQuery &query);
+    static bool isOwnRequest(const QWebEngineUrlRequestJob *job);
+    static void reply(QWebEngineUrlRequestJob *job, const QByteArray &contentType, const QByteArray &data);
+};
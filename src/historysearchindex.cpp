@@ -0,0 +1,314 @@
+/*****************************************************************************
+ * historysearchindex.cpp
+ *****************************************************************************
+ * Copyright (C) 2026 MX Authors
+ *
+ * Authors: Adrian <adrian@mxlinux.org>
+ *          MX Linux <http://mxlinux.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MX Viewer is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MX Viewer.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#include "historysearchindex.h"
+#include "historystore.h"
+
+#include <QCoreApplication>
+#include <QHash>
+
+#include <algorithm>
+
+HistorySearchIndex::HistorySearchIndex(QObject *parent)
+    : QObject(parent)
+{
+    auto *store = HistoryStore::instance();
+    connect(store, &HistoryStore::entryAdded, this, &HistorySearchIndex::entryAdded);
+    connect(store, &HistoryStore::entryVisited, this, &HistorySearchIndex::entryVisited);
+    connect(store, &HistoryStore::entryRemoved, this, &HistorySearchIndex::entryRemoved);
+    // Results are ordered by last visit, which removing visits can change.
+    connect(store, &HistoryStore::visitsRemoved, this, &HistorySearchIndex::invalidateCache);
+    connect(store, &HistoryStore::cleared, this, &HistorySearchIndex::cleared);
+}
+
+HistorySearchIndex::~HistorySearchIndex()
+{
+    if (builder) {
+        builder->wait();
+        delete builder;
+    }
+}
+
+HistorySearchIndex *HistorySearchIndex::instance()
+{
+    static auto *index = new HistorySearchIndex(QCoreApplication::instance());
+    return index;
+}
+
+// Lowercased runs of letters and digits. Scheme and "www" words are left out, they match nearly every URL.
+QStringList HistorySearchIndex::tokenize(const QString &text)
+{
+    QStringList result;
+    QString token;
+    const auto flush = [&result, &token] {
+        if (!token.isEmpty() && token != "http" && token != "https" && token != "www") {
+            result.append(token);
+        }
+        token.clear();
+    };
+    for (const QChar c : text) {
+        if (c.isLetterOrNumber()) {
+            token += c.toLower();
+        } else {
+            flush();
+        }
+    }
+    flush();
+    result.removeDuplicates();
+    return result;
+}
+
+void HistorySearchIndex::addEntry(Tokens *tokens, QHash<int, size_t> *titles, int id, const QString &title,
+                                  const QString &url)
+{
+    titles->insert(id, qHash(title));
+    const auto posting = static_cast<quint32>(id) << 1;
+    for (const QString &token : tokenize(title)) {
+        (*tokens)[token].append(posting | titleFlag);
+    }
+    for (const QString &token : tokenize(url)) {
+        (*tokens)[token].append(posting);
+    }
+}
+
+// Start building the index in the background, e.g. when the history page is opened.
+void HistorySearchIndex::prepare()
+{
+    if (ready || builder) {
+        return;
+    }
+    auto job = std::make_shared<BuildJob>();
+    job->generation = generation;
+    buildJob = job;
+    const HistoryStore::Snapshot snapshot = HistoryStore::instance()->snapshot();
+    builder = QThread::create([job, snapshot] {
+        HistoryStore::forEachEntry(snapshot, [&job](const HistoryEntry &entry) {
+            addEntry(&job->tokens, &job->titles, entry.id, entry.title, entry.url);
+        });
+    });
+    connect(builder, &QThread::finished, this, [this] {
+        builder->deleteLater();
+        builder = nullptr;
+        finishBuild();
+    });
+    builder->start(QThread::LowPriority);
+}
+
+// Install the result of the build and catch up with entries added while it ran.
+// Called from the thread's finished signal or directly after waiting for the thread.
+void HistorySearchIndex::finishBuild()
+{
+    if (!buildJob) {
+        return;
+    }
+    const std::shared_ptr<BuildJob> job = std::move(buildJob);
+    if (job->generation != generation) {
+        return;
+    }
+    tokens = std::move(job->tokens);
+    titles = std::move(job->titles);
+    ready = true;
+    const auto *store = HistoryStore::instance();
+    for (const int id : std::as_const(pendingIds)) {
+        const HistoryEntry entry = store->entry(id);
+        if (!entry.isValid()) {
+            continue;
+        }
+        if (titles.contains(id)) {
+            entryVisited(entry);
+        } else {
+            addEntry(&tokens, &titles, entry.id, entry.title, entry.url);
+        }
+    }
+    pendingIds.clear();
+    invalidateCache();
+}
+
+void HistorySearchIndex::waitUntilReady()
+{
+    if (ready) {
+        return;
+    }
+    prepare();
+    if (builder) {
+        builder->wait();
+    }
+    finishBuild();
+}
+
+// Return the ids of the entries matching every word of the query, best match first.
+QList<int> HistorySearchIndex::search(const QString &query)
+{
+    const QStringList terms = tokenize(query);
+    if (terms.isEmpty()) {
+        return {};
+    }
+    const QString key = terms.join(' ');
+    if (ready && key == cachedQuery) {
+        return cachedResults;
+    }
+    waitUntilReady();
+
+    // Per entry score: title word 2, URL word 1, doubled for a whole word match; summed over the query words.
+    QHash<int, int> scores;
+    for (qsizetype i = 0; i < terms.size(); ++i) {
+        const QString &term = terms.at(i);
+        QHash<int, int> termScores;
+        for (auto it = tokens.lowerBound(term); it != tokens.constEnd() && it.key().startsWith(term); ++it) {
+            const int weight = it.key().size() == term.size() ? 2 : 1;
+            for (const quint32 posting : it.value()) {
+                const auto id = static_cast<int>(posting >> 1);
+                if (i > 0 && !scores.contains(id)) {
+                    continue;
+                }
+                const int score = weight * ((posting & titleFlag) ? 2 : 1);
+                int &best = termScores[id];
+                best = qMax(best, score);
+            }
+        }
+        if (i == 0) {
+            scores = std::move(termScores);
+        } else {
+            for (auto it = scores.begin(); it != scores.end();) {
+                const auto match = termScores.constFind(it.key());
+                if (match == termScores.constEnd()) {
+                    it = scores.erase(it);
+                } else {
+                    it.value() += match.value();
+                    ++it;
+                }
+            }
+        }
+        if (scores.isEmpty()) {
+            break;
+        }
+    }
+
+    // Equal scores are ordered by last visit.
+    struct Match {
+        int score;
+        qint64 lastVisit;
+        int id;
+    };
+    const auto *store = HistoryStore::instance();
+    QList<Match> ranked;
+    ranked.reserve(scores.size());
+    for (auto it = scores.constBegin(); it != scores.constEnd(); ++it) {
+        if (!removedIds.contains(it.key())) {
+            ranked.append({it.value(), store->position(it.key()).lastVisit, it.key()});
+        }
+    }
+    std::sort(ranked.begin(), ranked.end(), [](const Match &a, const Match &b) {
+        if (a.score != b.score) {
+            return a.score > b.score;
+        }
+        return a.lastVisit != b.lastVisit ? a.lastVisit > b.lastVisit : a.id > b.id;
+    });
+    QList<int> result;
+    result.reserve(ranked.size());
+    for (const Match &match : std::as_const(ranked)) {
+        result.append(match.id);
+    }
+    cachedQuery = key;
+    cachedResults = result;
+    return result;
+}
+
+void HistorySearchIndex::invalidateCache()
+{
+    cachedQuery.clear();
+    cachedResults.clear();
+}
+
+// Drop the postings of deleted entries once enough of them have piled up.
+void HistorySearchIndex::purgeRemoved()
+{
+    for (auto it = tokens.begin(); it != tokens.end();) {
+        it.value().removeIf([this](quint32 posting) { return removedIds.contains(static_cast<int>(posting >> 1)); });
+        if (it.value().isEmpty()) {
+            it = tokens.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    removedIds.clear();
+}
+
+void HistorySearchIndex::entryAdded(const HistoryEntry &entry)
+{
+    if (ready) {
+        addEntry(&tokens, &titles, entry.id, entry.title, entry.url);
+        invalidateCache();
+    } else if (builder) {
+        pendingIds.append(entry.id);
+    }
+}
+
+// A visit can bring a new title; its words are added, words of the old title are left behind.
+void HistorySearchIndex::entryVisited(const HistoryEntry &entry)
+{
+    if (!ready) {
+        if (builder) {
+            pendingIds.append(entry.id);
+        }
+        return;
+    }
+    const size_t titleHash = qHash(entry.title);
+    auto it = titles.find(entry.id);
+    if (it != titles.end() && it.value() == titleHash) {
+        invalidateCache();
+        return;
+    }
+    titles.insert(entry.id, titleHash);
+    const auto posting = (static_cast<quint32>(entry.id) << 1) | titleFlag;
+    for (const QString &token : tokenize(entry.title)) {
+        Postings &postings = tokens[token];
+        if (!postings.contains(posting)) {
+            postings.append(posting);
+        }
+    }
+    invalidateCache();
+}
+
+void HistorySearchIndex::entryRemoved(const HistoryEntry &entry)
+{
+    if (!ready && !builder) {
+        return;
+    }
+    removedIds.insert(entry.id);
+    titles.remove(entry.id);
+    invalidateCache();
+    if (ready && removedIds.size() >= purgeThreshold) {
+        purgeRemoved();
+    }
+}
+
+// A build in flight describes the old history and is discarded when it finishes.
+void HistorySearchIndex::cleared()
+{
+    ++generation;
+    tokens.clear();
+    titles.clear();
+    removedIds.clear();
+    pendingIds.clear();
+    invalidateCache();
+    ready = true;
+}
@@ -0,0 +1,94 @@
+/*****************************************************************************
+ * historysearchindex.h
+ *****************************************************************************
+ * Copyright (C) 2026 MX Authors
+ *
+ * Authors: Adrian <adrian@mxlinux.org>
+ *          MX Linux <http://mxlinux.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MX Viewer is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MX Viewer.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#pragma once
+
+#include <QHash>
+#include <QList>
+#include <QMap>
+#include <QObject>
+#include <QPointer>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+#include <QThread>
+
+#include <memory>
+
+struct HistoryEntry;
+
+// In-memory inverted index over the words of history titles and URLs. Every
+// query word is matched as a prefix and all words must match; results are
+// ranked by where and how well the words matched, then by recency. The index
+// is built from the history log on a worker thread the first time it is
+// needed and then kept up to date from HistoryStore's signals.
+class HistorySearchIndex : public QObject
+{
+    Q_OBJECT
+
+public:
+    static HistorySearchIndex *instance();
+    ~HistorySearchIndex() override;
+
+    void prepare();
+    [[nodiscard]] QList<int> search(const QString &query);
+
+    [[nodiscard]] static QStringList tokenize(const QString &text);
+
+private:
+    explicit HistorySearchIndex(QObject *parent = nullptr);
+
+    // Postings are entry ids shifted left by one, the low bit is set for title words.
+    using Postings = QList<quint32>;
+    using Tokens = QMap<QString, Postings>;
+
+    struct BuildJob {
+        int generation {};
+        Tokens tokens;
+        QHash<int, size_t> titles;
+    };
+
+    Tokens tokens;
+    QHash<int, size_t> titles; // Hash of the indexed title of every entry
+    std::shared_ptr<BuildJob> buildJob;
+    QSet<int> removedIds;
+    QList<int> pendingIds;
+    int generation {};
+    bool ready {};
+    QPointer<QThread> builder;
+
+    QString cachedQuery;
+    QList<int> cachedResults;
+
+    static constexpr quint32 titleFlag {1};
+    static constexpr int purgeThreshold {1024};
+
+    static void addEntry(Tokens *tokens, QHash<int, size_t> *titles, int id, const QString &title,
+                         const QString &url);
+    void finishBuild();
+    void waitUntilReady();
+    void invalidateCache();
+    void purgeRemoved();
+    void entryAdded(const HistoryEntry &entry);
+    void entryVisited(const HistoryEntry &entry);
+    void entryRemoved(const HistoryEntry &entry);
+    void cleared();
+};
@@ -0,0 +1,2043 @@
+/*****************************************************************************
+ * historystore.cpp
+ *****************************************************************************
+ * Copyright (C) 2026 MX Authors
+ *
+ * Authors: Adrian <adrian@mxlinux.org>
+ *          MX Linux <http://mxlinux.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MX Viewer is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MX Viewer.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#include "historystore.h"
+#include "faviconstore.h"
+#include "settings.h"
+
+#include <QCoreApplication>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QMutex>
+#include <QStandardPaths>
+#include <QThread>
+#include <QUrl>
+#include <QWaitCondition>
+#include <QtEndian>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <memory>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+// Every log record is framed as: quint32 payload size, quint16 checksum, payload.
+constexpr qint64 recordHeaderSize {6};
+constexpr quint32 maxRecordSize {16 * 1024 * 1024};
+
+// Compact once this many superseded or deleted records are in the log and they
+// make up at least a quarter of it.
+constexpr int compactionMinDeadRecords {512};
+
+// Entry records written before visits were aggregated have no visit data.
+enum RecordType : quint8 {
+    EntryRecord = 1,
+    DeleteRecord = 2,
+    VisitedEntryRecord = 3,
+};
+
+QByteArray fileHeader(quint32 magic, quint32 version)
+{
+    QByteArray header(8, Qt::Uninitialized);
+    qToBigEndian<quint32>(magic, header.data());
+    qToBigEndian<quint32>(version, header.data() + 4);
+    return header;
+}
+
+QByteArray frameRecord(const QByteArray &payload)
+{
+    QByteArray record(recordHeaderSize, Qt::Uninitialized);
+    qToBigEndian<quint32>(static_cast<quint32>(payload.size()), record.data());
+    qToBigEndian<quint16>(qChecksum(payload), record.data() + 4);
+    record += payload;
+    return record;
+}
+
+// Size of the framed record at offset, header included, or 0 if it cannot be read.
+qint64 framedRecordSize(QFile &file, qint64 offset)
+{
+    if (offset < 0 || !file.seek(offset)) {
+        return 0;
+    }
+    const QByteArray header = file.read(recordHeaderSize);
+    if (header.size() != recordHeaderSize) {
+        return 0;
+    }
+    return recordHeaderSize + qFromBigEndian<quint32>(header.constData());
+}
+
+QByteArray encodeEntry(const HistoryEntry &entry)
+{
+    QByteArray payload;
+    QDataStream stream(&payload, QIODevice::WriteOnly);
+    stream.setVersion(QDataStream::Qt_6_0);
+    stream << quint8(VisitedEntryRecord) << qint32(entry.id) << entry.title << entry.url << entry.iconRef
+           << qint32(entry.visitCount) << entry.firstVisit << entry.lastVisit << entry.visits;
+    return frameRecord(payload);
+}
+
+QByteArray encodeDelete(int id)
+{
+    QByteArray payload;
+    QDataStream stream(&payload, QIODevice::WriteOnly);
+    stream.setVersion(QDataStream::Qt_6_0);
+    stream << quint8(DeleteRecord) << qint32(id);
+    return frameRecord(payload);
+}
+
+// Read the framed record at offset, returning it whole (header included) or an empty array if it is torn or damaged.
+QByteArray readFramedRecord(QFile &file, qint64 offset)
+{
+    if (!file.seek(offset)) {
+        return {};
+    }
+    QByteArray record = file.read(recordHeaderSize);
+    if (record.size() != recordHeaderSize) {
+        return {};
+    }
+    const auto size = qFromBigEndian<quint32>(record.constData());
+    const auto checksum = qFromBigEndian<quint16>(record.constData() + 4);
+    if (size == 0 || size > maxRecordSize) {
+        return {};
+    }
+    const QByteArray payload = file.read(size);
+    if (payload.size() != qsizetype(size) || qChecksum(payload) != checksum) {
+        return {};
+    }
+    record += payload;
+    return record;
+}
+
+// Both kinds of entry records decode to EntryRecord.
+bool decodeRecord(const QByteArray &record, quint8 *type, HistoryEntry *entry)
+{
+    QDataStream stream(record.mid(recordHeaderSize));
+    stream.setVersion(QDataStream::Qt_6_0);
+    qint32 id {-1};
+    stream >> *type >> id;
+    if (*type == EntryRecord || *type == VisitedEntryRecord) {
+        stream >> entry->title >> entry->url >> entry->iconRef;
+    } else if (*type != DeleteRecord) {
+        return false;
+    }
+    if (*type == VisitedEntryRecord) {
+        qint32 visitCount {};
+        stream >> visitCount >> entry->firstVisit >> entry->lastVisit >> entry->visits;
+        entry->visitCount = visitCount;
+        *type = EntryRecord;
+    }
+    entry->id = id;
+    return stream.status() == QDataStream::Ok && id >= 0;
+}
+
+// Count visits made at the given times, keeping the times of the latest maxVisits of them.
+void addVisits(HistoryEntry *entry, const QList<qint64> &visits, const QString &title)
+{
+    if (visits.isEmpty()) {
+        return;
+    }
+    entry->visitCount += static_cast<int>(visits.size());
+    entry->visits += visits;
+    std::sort(entry->visits.begin(), entry->visits.end());
+    if (entry->visits.size() > HistoryEntry::maxVisits) {
+        entry->visits.remove(0, entry->visits.size() - HistoryEntry::maxVisits);
+    }
+    entry->lastVisit = qMax(entry->lastVisit, entry->visits.constLast());
+    if (entry->firstVisit == 0) {
+        entry->firstVisit = *std::min_element(visits.cbegin(), visits.cend());
+    }
+    if (!title.isEmpty()) {
+        entry->title = title;
+    }
+}
+
+// Add the visits of another entry for the same URL to an entry, which keeps its id and title.
+void mergeEntry(HistoryEntry *target, const HistoryEntry &other)
+{
+    target->visitCount += other.visitCount;
+    if (other.firstVisit > 0 && (target->firstVisit == 0 || other.firstVisit < target->firstVisit)) {
+        target->firstVisit = other.firstVisit;
+    }
+    target->lastVisit = qMax(target->lastVisit, other.lastVisit);
+    target->visits = other.visits + target->visits;
+    std::sort(target->visits.begin(), target->visits.end());
+    if (target->visits.size() > HistoryEntry::maxVisits) {
+        target->visits.remove(0, target->visits.size() - HistoryEntry::maxVisits);
+    }
+    if (target->iconRef.isEmpty()) {
+        target->iconRef = other.iconRef;
+    }
+}
+
+// Take out the visits made in [from, to). Visits that fell out of the visit list count as made at the
+// first visit. False when none was in the range; a visit count of 0 is left when all were.
+bool dropVisits(HistoryEntry *entry, qint64 from, qint64 to)
+{
+    const auto inRange = [from, to](qint64 time) { return time >= from && time < to; };
+    const qsizetype olderBefore = entry->visitCount - entry->visits.size();
+    const qsizetype olderAfter = inRange(entry->firstVisit) ? 0 : olderBefore;
+    QList<qint64> visits = entry->visits;
+    visits.removeIf(inRange);
+    const qsizetype kept = olderAfter + visits.size();
+    if (kept == entry->visitCount) {
+        return false;
+    }
+    entry->visits = visits;
+    entry->visitCount = static_cast<int>(qMax<qsizetype>(kept, 0));
+    if (entry->visitCount > 0) {
+        if (olderAfter == 0) {
+            entry->firstVisit = visits.constFirst();
+        }
+        entry->lastVisit = visits.isEmpty() ? entry->firstVisit : visits.constLast();
+    }
+    return true;
+}
+
+// Exclusive lock on a file shared by all processes using the same history, held for the lifetime
+// of the object. The lock file is never replaced, unlike the log. Closing it releases the lock, also
+// when a process dies.
+class FileLock
+{
+public:
+    explicit FileLock(const QString &path)
+        : fd(::open(QFile::encodeName(path).constData(), O_RDWR | O_CREAT | O_CLOEXEC, 0600))
+    {
+        if (fd < 0) {
+            qWarning() << "Could not open history lock" << path;
+            return;
+        }
+        while (::flock(fd, LOCK_EX) != 0 && errno == EINTR) { }
+    }
+    ~FileLock()
+    {
+        if (fd >= 0) {
+            ::close(fd);
+        }
+    }
+    FileLock(const FileLock &) = delete;
+    FileLock &operator=(const FileLock &) = delete;
+
+private:
+    int fd {-1};
+};
+
+// Stable 64-bit FNV-1a hash of a URL, kept in the index to find entries by URL without reading the log.
+quint64 urlKey(const QString &url)
+{
+    quint64 hash {0xcbf29ce484222325};
+    for (const QChar c : url) {
+        hash = (hash ^ c.unicode()) * 0x100000001b3;
+    }
+    return hash;
+}
+} // namespace
+
+// Writes queued changes in batches on its own thread. The queue holds at most one change per entry
+// id, later changes to the same entry are merged into it, so a visit and its icon become one record.
+//
+// Several processes may share the log. Every batch is written under an exclusive lock on the lock
+// file; before writing, the records other processes appended are read and passed on to the store,
+// and visits are added to the latest record of their entry rather than overwriting it, so visits
+// recorded concurrently are all kept. A new entry for a URL another process added meanwhile is
+// merged into that entry. A log is never shrunk in place: clearing and compaction write
+// a new file and rename it over the old one, which tells the other processes to reload. Readers
+// never take the lock.
+class HistoryStore::Writer
+{
+public:
+    Writer(HistoryStore *store, const QString &logPath, const QString &indexPath, const QString &lockPath,
+           const QList<Slot> &table, int deadRecords);
+    ~Writer();
+
+    void add(const HistoryEntry &entry, quint64 sequence);
+    void visit(const HistoryEntry &entry, qint64 time, quint64 sequence);
+    void setIcon(int id, const QByteArray &iconRef, quint64 sequence);
+    void remove(int id);
+    void removeVisits(qint64 from, qint64 to);
+    void clear(int generation);
+    void flush();
+    void collectIcons();
+    [[nodiscard]] std::pair<int, int> takeIds();
+
+private:
+    enum class ChangeType { Entry, Icon, Delete };
+    // An entry change either replaces the stored record or only adds visits (and maybe an icon) to it.
+    // Added entries are new, and may still be stored under another id.
+    struct Change {
+        ChangeType type {};
+        HistoryEntry entry;
+        QList<qint64> visits;
+        bool replace {};
+        bool iconChanged {};
+        quint64 sequence {};
+        bool added {};
+    };
+    using FileId = std::pair<dev_t, ino_t>;
+
+    HistoryStore *store;
+    QThread *thread {};
+    QString lockPath;
+
+    // Only used by the writer thread.
+    QMutex fileMutex;
+    QFile log;
+    QFile index;
+    FileId logId {};
+    qint64 knownSize {};
+    QList<Slot> table;
+    int deadRecords {};
+    qint64 liveBytes {};
+    QList<std::pair<int, int>> ownBlocks; // Ids reserved by this process
+    QHash<int, int> moves;                // Ids of entries stored under another id, and that id
+
+    QMutex mutex;
+    QWaitCondition wakeUp;
+    QWaitCondition idle;
+    QHash<int, Change> queue;
+    QList<int> order;
+    int generation {};
+    std::pair<int, int> reservedIds {};
+    QList<std::pair<qint64, qint64>> ranges;
+    bool clearRequested {};
+    bool flushRequested {};
+    bool iconsRequested {};
+    bool reserveRequested {true};
+    bool busy {};
+    bool stopping {};
+
+    static constexpr int flushInterval {1000};
+    static constexpr int syncInterval {2000};
+    static constexpr int maxQueued {1024};
+    static constexpr int idBlockSize {64};
+
+    void enqueue(const Change &change);
+    [[nodiscard]] bool hasWork() const;
+    [[nodiscard]] bool ownsId(int id) const;
+    [[nodiscard]] bool changedElsewhere();
+    void run();
+    void measure();
+    void gatherIcons(int batchGeneration);
+    void trimRanges(const QList<std::pair<qint64, qint64>> &removals, int batchGeneration);
+    std::pair<int, int> writeBatch(const QList<Change> &changes, bool clearLog, bool reserve, int batchGeneration);
+    void sync(int batchGeneration);
+    void reload(int batchGeneration);
+    qint64 scan(QFile &file, qint64 from, QList<Slot> *target, int *dead, qint64 *bytes,
+                QHash<int, Synced> *changes);
+    void postReplaced(int batchGeneration, const QList<Synced> &changes);
+    void maybeCompact(int batchGeneration);
+    bool replaceLog(bool keepRecords, int batchGeneration);
+    [[nodiscard]] static FileId fileId(const QFile &file);
+};
+
+HistoryStore::Writer::Writer(HistoryStore *store, const QString &logPath, const QString &indexPath,
+                             const QString &lockPath, const QList<Slot> &table, int deadRecords)
+    : store(store),
+      lockPath(lockPath),
+      log(logPath),
+      index(indexPath),
+      table(table),
+      deadRecords(deadRecords)
+{
+    if (!log.open(QIODevice::ReadWrite) || !index.open(QIODevice::ReadWrite)) {
+        qWarning() << "Could not open history files for writing" << logPath;
+    }
+    logId = fileId(log);
+    knownSize = log.size();
+    thread = QThread::create([this] { run(); });
+    thread->start();
+}
+
+// Write whatever is still queued before returning.
+HistoryStore::Writer::~Writer()
+{
+    {
+        QMutexLocker locker(&mutex);
+        stopping = true;
+        wakeUp.wakeOne();
+    }
+    thread->wait();
+    delete thread;
+}
+
+HistoryStore::Writer::FileId HistoryStore::Writer::fileId(const QFile &file)
+{
+    struct stat info {};
+    if (file.handle() < 0 || ::fstat(file.handle(), &info) != 0) {
+        return {};
+    }
+    return {info.st_dev, info.st_ino};
+}
+
+void HistoryStore::Writer::add(const HistoryEntry &entry, quint64 sequence)
+{
+    enqueue({ChangeType::Entry, entry, {}, true, false, sequence, true});
+}
+
+void HistoryStore::Writer::visit(const HistoryEntry &entry, qint64 time, quint64 sequence)
+{
+    enqueue({ChangeType::Entry, entry, {time}, false, false, sequence});
+}
+
+void HistoryStore::Writer::setIcon(int id, const QByteArray &iconRef, quint64 sequence)
+{
+    HistoryEntry entry;
+    entry.id = id;
+    entry.iconRef = iconRef;
+    enqueue({ChangeType::Icon, entry, {}, false, true, sequence});
+}
+
+void HistoryStore::Writer::remove(int id)
+{
+    HistoryEntry entry;
+    entry.id = id;
+    enqueue({ChangeType::Delete, entry, {}, false, false, 0});
+}
+
+// Remove the visits made in [from, to) after the changes queued so far are written.
+void HistoryStore::Writer::removeVisits(qint64 from, qint64 to)
+{
+    QMutexLocker locker(&mutex);
+    ranges.append({from, to});
+    wakeUp.wakeOne();
+}
+
+// Changes queued so far describe the old history and are dropped.
+void HistoryStore::Writer::clear(int generation)
+{
+    QMutexLocker locker(&mutex);
+    queue.clear();
+    order.clear();
+    ranges.clear();
+    clearRequested = true;
+    this->generation = generation;
+    wakeUp.wakeOne();
+}
+
+// Block until everything queued so far is on disk.
+void HistoryStore::Writer::flush()
+{
+    QMutexLocker locker(&mutex);
+    flushRequested = true;
+    wakeUp.wakeOne();
+    while (!order.isEmpty() || clearRequested || flushRequested || busy) {
+        idle.wait(&mutex);
+    }
+}
+
+// Ask for the favicons and hosts the live entries use, reported to the store after the next batch.
+void HistoryStore::Writer::collectIcons()
+{
+    QMutexLocker locker(&mutex);
+    iconsRequested = true;
+    wakeUp.wakeOne();
+}
+
+// Hand out the block of ids reserved in advance and have the next one reserved. Never waits: right
+// after startup or a burst of new entries no block may be ready, then {first, 0} is returned.
+std::pair<int, int> HistoryStore::Writer::takeIds()
+{
+    QMutexLocker locker(&mutex);
+    const std::pair<int, int> result = std::exchange(reservedIds, {});
+    reserveRequested = true;
+    wakeUp.wakeOne();
+    return result;
+}
+
+void HistoryStore::Writer::enqueue(const Change &change)
+{
+    const int id = change.entry.id;
+    QMutexLocker locker(&mutex);
+    auto it = queue.find(id);
+    if (it == queue.end()) {
+        // Never waits: a full queue is written at once instead of after flushInterval, and it holds
+        // one change per entry, so it grows no further than the entries changed meanwhile.
+        if (order.isEmpty() || order.size() >= maxQueued) {
+            wakeUp.wakeOne();
+        }
+        order.append(id);
+        queue.insert(id, change);
+        return;
+    }
+    Change &queued = it.value();
+    if (change.type == ChangeType::Delete) {
+        // An entry removed before it was written leaves nothing to write.
+        if (queued.added) {
+            queue.erase(it);
+            order.removeOne(id);
+        } else {
+            queued = change;
+        }
+        return;
+    }
+    if (queued.type == ChangeType::Delete) {
+        if (change.type == ChangeType::Entry) {
+            queued = change;
+        }
+        return;
+    }
+    if (change.type == ChangeType::Icon) {
+        queued.entry.iconRef = change.entry.iconRef;
+        queued.iconChanged = true;
+        queued.sequence = change.sequence;
+        return;
+    }
+    // Visits to a whole record still queued are added to it, the change may only name the entry.
+    if (queued.replace && !change.replace) {
+        addVisits(&queued.entry, change.visits, change.entry.title);
+        if (change.iconChanged) {
+            queued.entry.iconRef = change.entry.iconRef;
+        }
+        queued.sequence = change.sequence;
+        return;
+    }
+    // The new change has the whole entry as the store sees it, only an icon set meanwhile may be newer.
+    Change merged = change;
+    merged.visits = queued.visits + change.visits;
+    merged.replace = queued.replace || change.replace;
+    merged.added = queued.added || change.added;
+    if (queued.iconChanged) {
+        merged.entry.iconRef = queued.entry.iconRef;
+        merged.iconChanged = true;
+    }
+    queued = merged;
+}
+
+bool HistoryStore::Writer::hasWork() const
+{
+    return !order.isEmpty() || !ranges.isEmpty() || clearRequested || flushRequested || reserveRequested
+        || iconsRequested || stopping;
+}
+
+bool HistoryStore::Writer::ownsId(int id) const
+{
+    return std::any_of(ownBlocks.cbegin(), ownBlocks.cend(), [id](const std::pair<int, int> &block) {
+        return id >= block.first && id < block.first + block.second;
+    });
+}
+
+// Whether another process appended to the log or replaced it since the last sync.
+bool HistoryStore::Writer::changedElsewhere()
+{
+    QMutexLocker locker(&fileMutex);
+    struct stat info {};
+    if (::stat(QFile::encodeName(log.fileName()).constData(), &info) != 0) {
+        return false;
+    }
+    return FileId {info.st_dev, info.st_ino} != logId || info.st_size > knownSize;
+}
+
+// Sum up the size of the live records, for the retention size limit.
+void HistoryStore::Writer::measure()
+{
+    liveBytes = 0;
+    for (const Slot &slot : std::as_const(table)) {
+        liveBytes += framedRecordSize(log, slot.offset);
+    }
+}
+
+// Read every live record for the favicons and hosts in use. Slow on a big log, but only done some
+// time after deletions.
+void HistoryStore::Writer::gatherIcons(int batchGeneration)
+{
+    QMutexLocker locker(&fileMutex);
+    QSet<QByteArray> refs;
+    QSet<QString> hosts;
+    for (const Slot &slot : std::as_const(table)) {
+        HistoryEntry entry;
+        quint8 type {};
+        if (slot.offset < 0 || !decodeRecord(readFramedRecord(log, slot.offset), &type, &entry)
+            || type != EntryRecord) {
+            continue;
+        }
+        if (!entry.iconRef.isEmpty()) {
+            refs.insert(entry.iconRef);
+        }
+        hosts.insert(QUrl(entry.url).host());
+    }
+    QMetaObject::invokeMethod(
+        store,
+        [store = store, batchGeneration, refs, hosts] { store->iconsCollected(batchGeneration, refs, hosts); },
+        Qt::QueuedConnection);
+}
+
+// Under the lock: take the visits made in the ranges out of the latest records and delete the
+// entries left without visits, then report the ranges as done. Every entry with a visit in a range
+// has its last visit at or after the start of it, so only those are read.
+void HistoryStore::Writer::trimRanges(const QList<std::pair<qint64, qint64>> &removals, int batchGeneration)
+{
+    QMutexLocker locker(&fileMutex);
+    FileLock lock(lockPath);
+    sync(batchGeneration);
+    qint64 earliest = std::numeric_limits<qint64>::max();
+    for (const auto &[from, to] : removals) {
+        earliest = qMin(earliest, from);
+    }
+    const qint64 base = log.size();
+    const qint64 previousLiveBytes = liveBytes;
+    QByteArray data;
+    QList<Trimmed> trimmed;
+    int dead {};
+    for (int id = 0; id < table.size(); ++id) {
+        const Slot &slot = table.at(id);
+        if (slot.offset < 0 || slot.lastVisit < earliest) {
+            continue;
+        }
+        Trimmed change;
+        quint8 type {};
+        if (!decodeRecord(readFramedRecord(log, slot.offset), &type, &change.before) || type != EntryRecord) {
+            continue;
+        }
+        change.after = change.before;
+        bool changed {};
+        for (const auto &[from, to] : removals) {
+            changed = dropVisits(&change.after, from, to) || changed;
+        }
+        if (!changed) {
+            continue;
+        }
+        ++dead;
+        liveBytes -= framedRecordSize(log, slot.offset);
+        if (change.after.visitCount == 0) {
+            data += encodeDelete(id);
+            ++dead;
+        } else {
+            change.offset = base + data.size();
+            const QByteArray record = encodeEntry(change.after);
+            liveBytes += record.size();
+            data += record;
+        }
+        trimmed.append(change);
+    }
+    if (!data.isEmpty() && writeRecord(log, data) < 0) {
+        log.resize(base);
+        liveBytes = previousLiveBytes;
+        trimmed.clear();
+    } else if (!data.isEmpty()) {
+        knownSize = log.size();
+        for (const Trimmed &change : std::as_const(trimmed)) {
+            const Slot slot = change.offset < 0
+                ? Slot {}
+                : Slot {change.offset, change.after.lastVisit, urlKey(change.after.url)};
+            table[change.before.id] = slot;
+            writeIndexSlot(index, change.before.id, slot);
+        }
+        deadRecords += dead;
+        writeIndexHeader(index, log.size(), deadRecords);
+    }
+    QMetaObject::invokeMethod(
+        store,
+        [store = store, batchGeneration, removals, trimmed] { store->trimmed(batchGeneration, removals, trimmed); },
+        Qt::QueuedConnection);
+    if (!data.isEmpty()) {
+        QMetaObject::invokeMethod(
+            store, [store = store, batchGeneration, bytes = liveBytes] { store->measured(batchGeneration, bytes); },
+            Qt::QueuedConnection);
+        maybeCompact(batchGeneration);
+    }
+}
+
+void HistoryStore::Writer::run()
+{
+    {
+        QMutexLocker locker(&fileMutex);
+        measure();
+        QMutexLocker queueLocker(&mutex);
+        const int currentGeneration = generation;
+        QMetaObject::invokeMethod(
+            store,
+            [store = store, currentGeneration, bytes = liveBytes] { store->measured(currentGeneration, bytes); },
+            Qt::QueuedConnection);
+    }
+    QMutexLocker locker(&mutex);
+    while (true) {
+        // When idle, look for changes made by other processes now and then.
+        while (!hasWork()) {
+            if (!wakeUp.wait(&mutex, syncInterval) && !hasWork()) {
+                locker.unlock();
+                const bool changed = changedElsewhere();
+                locker.relock();
+                if (changed) {
+                    break;
+                }
+            }
+        }
+        // Give further changes a moment to arrive so they are written together.
+        if (!order.isEmpty() && !flushRequested && !stopping && order.size() < maxQueued) {
+            wakeUp.wait(&mutex, flushInterval);
+        }
+        QList<Change> changes;
+        changes.reserve(order.size());
+        for (const int id : std::as_const(order)) {
+            changes.append(queue.value(id));
+        }
+        queue.clear();
+        order.clear();
+        const bool clearLog = std::exchange(clearRequested, false);
+        const bool reserve = reserveRequested && reservedIds.second == 0;
+        const bool collect = std::exchange(iconsRequested, false) && !stopping;
+        const QList<std::pair<qint64, qint64>> removals = std::exchange(ranges, {});
+        const int batchGeneration = generation;
+        flushRequested = false;
+        busy = true;
+        locker.unlock();
+        const std::pair<int, int> ids = writeBatch(changes, clearLog, reserve, batchGeneration);
+        if (!removals.isEmpty()) {
+            trimRanges(removals, batchGeneration);
+        }
+        if (collect) {
+            gatherIcons(batchGeneration);
+        }
+        locker.relock();
+        if (reserve) {
+            reservedIds = ids;
+            reserveRequested = false;
+        }
+        busy = false;
+        idle.wakeAll();
+        if (stopping && order.isEmpty() && !clearRequested) {
+            return;
+        }
+    }
+}
+
+// Under the lock: catch up with other processes, then append the records of a batch with a single
+// write, update the index and let the store know where they ended up. Returns the reserved ids.
+std::pair<int, int> HistoryStore::Writer::writeBatch(const QList<Change> &changes, bool clearLog, bool reserve,
+                                                     int batchGeneration)
+{
+    QMutexLocker locker(&fileMutex);
+    FileLock lock(lockPath);
+    sync(batchGeneration);
+    if (clearLog) {
+        replaceLog(false, batchGeneration);
+        moves.clear();
+    }
+    if (changes.isEmpty() && !reserve) {
+        return {};
+    }
+    const qint64 base = log.size();
+    const qint64 previousLiveBytes = liveBytes;
+    int freeId = static_cast<int>(table.size());
+    QByteArray data;
+    QList<Written> written;
+    QList<Slot> writtenSlots;
+    QList<int> deleted;
+    QList<Moved> moved;
+    QMultiHash<quint64, int> byUrl; // Built when the first new entry is written
+    // Entries this batch wrote or deleted already are read from it: index in written and record
+    // size, or an index of -1 when deleted.
+    struct Latest {
+        qsizetype index {-1};
+        qint64 size {};
+    };
+    QHash<int, Latest> inBatch;
+    const auto latestOffset = [this, &inBatch, &written](int id) -> qint64 {
+        const auto done = inBatch.constFind(id);
+        if (done != inBatch.constEnd()) {
+            return done->index < 0 ? -1 : written.at(done->index).offset;
+        }
+        return id < table.size() ? table.at(id).offset : -1;
+    };
+    const auto readLatest = [this, &inBatch, &written, &latestOffset](int id, HistoryEntry *stored) {
+        const auto done = inBatch.constFind(id);
+        if (done != inBatch.constEnd() && done->index >= 0) {
+            *stored = written.at(done->index).entry;
+            return true;
+        }
+        const qint64 offset = latestOffset(id);
+        quint8 type {};
+        return offset >= 0 && decodeRecord(readFramedRecord(log, offset), &type, stored) && type == EntryRecord;
+    };
+    const auto latestSize = [this, &inBatch](int id) {
+        const auto done = inBatch.constFind(id);
+        return done != inBatch.constEnd() ? done->size : framedRecordSize(log, table.at(id).offset);
+    };
+    int dead {};
+    for (const Change &change : changes) {
+        // Changes made under the id an entry was added with go to the entry it is stored as.
+        const auto movedTo = moves.constFind(change.entry.id);
+        const bool redirected = movedTo != moves.constEnd();
+        int id = redirected ? movedTo.value() : change.entry.id;
+        if (change.type == ChangeType::Delete) {
+            if (latestOffset(id) >= 0) {
+                data += encodeDelete(id);
+                deleted.append(id);
+                dead += 2;
+                liveBytes -= latestSize(id);
+                inBatch.insert(id, {});
+            }
+            continue;
+        }
+        HistoryEntry entry = change.entry;
+        Moved move {change.entry.id, {}, {}};
+        bool reassigned {};
+        HistoryEntry existing;
+        if (change.added && !redirected) {
+            // Another process may have added the same URL meanwhile: its entry takes the visits.
+            if (byUrl.isEmpty()) {
+                for (int other = 0; other < table.size(); ++other) {
+                    if (table.at(other).offset >= 0) {
+                        byUrl.insert(table.at(other).urlKey, other);
+                    }
+                }
+            }
+            const quint64 key = urlKey(entry.url);
+            for (auto it = byUrl.constFind(key); it != byUrl.constEnd() && it.key() == key; ++it) {
+                if (it.value() != id && readLatest(it.value(), &existing) && existing.url == entry.url) {
+                    break;
+                }
+                existing = {};
+            }
+            // Added with a provisional id, which another process may hold.
+            if (!ownsId(id) && readLatest(id, &move.displaced.entry)) {
+                move.displaced.offset = latestOffset(id);
+            }
+        }
+        if (existing.isValid()) {
+            mergeEntry(&existing, entry);
+            if (!entry.title.isEmpty() && entry.lastVisit >= existing.lastVisit) {
+                existing.title = entry.title;
+            }
+            entry = existing;
+            id = existing.id;
+            reassigned = true;
+        } else if (change.added && !redirected && !ownsId(id)) {
+            id = freeId++;
+            reassigned = true;
+        } else if (!change.replace || redirected) {
+            // Add to the latest record, which may hold visits from other processes. An entry deleted
+            // meanwhile stays deleted.
+            HistoryEntry stored;
+            if (!readLatest(id, &stored)) {
+                continue;
+            }
+            // Only a 64-bit URL hash collision in the store could send a visit to another entry.
+            if (!entry.url.isEmpty() && entry.url != stored.url) {
+                qWarning() << "History visit for" << entry.url << "does not match entry" << id;
+                continue;
+            }
+            if (change.visits.isEmpty() && (!change.iconChanged || stored.iconRef == entry.iconRef)) {
+                continue;
+            }
+            addVisits(&stored, change.visits, entry.title);
+            if (change.iconChanged) {
+                stored.iconRef = entry.iconRef;
+            }
+            entry = stored;
+        }
+        entry.id = id;
+        if (latestOffset(id) >= 0) {
+            ++dead;
+            liveBytes -= latestSize(id);
+        }
+        const qint64 offset = base + data.size();
+        const QByteArray record = encodeEntry(entry);
+        inBatch.insert(id, {written.size(), record.size()});
+        written.append({id, offset, change.sequence, entry, !change.visits.isEmpty() && !change.added});
+        writtenSlots.append({offset, entry.lastVisit, urlKey(entry.url)});
+        if (reassigned) {
+            move.to = {offset, entry};
+            moved.append(move);
+        }
+        liveBytes += record.size();
+        data += record;
+    }
+    // A block of ids is taken by a tombstone for its last id, so every process sees it as used.
+    std::pair<int, int> ids {};
+    if (reserve) {
+        ids = {freeId, idBlockSize};
+        data += encodeDelete(ids.first + idBlockSize - 1);
+        ++dead;
+    }
+    if (data.isEmpty()) {
+        return {};
+    }
+    if (writeRecord(log, data) < 0) {
+        log.resize(base);
+        liveBytes = previousLiveBytes;
+        return {};
+    }
+    knownSize = log.size();
+    if (reserve) {
+        table.resize(ids.first + ids.second);
+        ownBlocks.append(ids);
+    }
+    for (qsizetype i = 0; i < written.size(); ++i) {
+        const int id = written.at(i).id;
+        if (id >= table.size()) {
+            table.resize(id + 1);
+        }
+        table[id] = writtenSlots.at(i);
+        writeIndexSlot(index, id, writtenSlots.at(i));
+    }
+    for (const int id : std::as_const(deleted)) {
+        table[id] = {};
+        writeIndexSlot(index, id, {});
+    }
+    if (reserve) {
+        writeIndexSlot(index, ids.first + ids.second - 1, {});
+    }
+    for (const Moved &move : std::as_const(moved)) {
+        moves.insert(move.from, move.to.entry.id);
+    }
+    deadRecords += dead;
+    writeIndexHeader(index, log.size(), deadRecords);
+    if (!written.isEmpty()) {
+        QMetaObject::invokeMethod(
+            store, [store = store, batchGeneration, written] { store->written(batchGeneration, written); },
+            Qt::QueuedConnection);
+    }
+    if (!moved.isEmpty()) {
+        QMetaObject::invokeMethod(
+            store, [store = store, batchGeneration, moved] { store->moved(batchGeneration, moved); },
+            Qt::QueuedConnection);
+    }
+    QMetaObject::invokeMethod(
+        store, [store = store, batchGeneration, bytes = liveBytes] { store->measured(batchGeneration, bytes); },
+        Qt::QueuedConnection);
+    maybeCompact(batchGeneration);
+    return ids;
+}
+
+// Pick up what other processes wrote since the last batch and pass it on to the store.
+void HistoryStore::Writer::sync(int batchGeneration)
+{
+    struct stat info {};
+    if (::stat(QFile::encodeName(log.fileName()).constData(), &info) == 0
+        && FileId {info.st_dev, info.st_ino} != logId) {
+        reload(batchGeneration);
+        return;
+    }
+    if (log.size() <= knownSize) {
+        return;
+    }
+    QHash<int, Synced> changes;
+    const qint64 end = scan(log, knownSize, &table, &deadRecords, &liveBytes, &changes);
+    if (end < log.size()) {
+        // Torn by a process that crashed while writing; nobody else writes while the lock is held.
+        qWarning() << "Truncating damaged history log at" << end;
+        log.resize(end);
+    }
+    knownSize = log.size();
+    if (!changes.isEmpty()) {
+        QMetaObject::invokeMethod(
+            store,
+            [store = store, batchGeneration, sync = Sync {false, {}, {}, changes.values()}] {
+                store->synced(batchGeneration, sync);
+            },
+            Qt::QueuedConnection);
+    }
+}
+
+// Read the records of file from offset on into target. When changes is given, entries written or
+// removed are collected in it, a removed one with an offset of -1 and its last record. Returns where
+// reading stopped.
+qint64 HistoryStore::Writer::scan(QFile &file, qint64 from, QList<Slot> *target, int *dead, qint64 *bytes,
+                                  QHash<int, Synced> *changes)
+{
+    qint64 offset = from;
+    while (offset < file.size()) {
+        const QByteArray record = readFramedRecord(file, offset);
+        quint8 type {};
+        HistoryEntry entry;
+        if (record.isEmpty() || !decodeRecord(record, &type, &entry)) {
+            break;
+        }
+        const int id = entry.id;
+        if (id >= target->size()) {
+            target->resize(id + 1);
+        }
+        const qint64 previous = target->at(id).offset;
+        if (previous >= 0) {
+            ++*dead;
+            if (bytes) {
+                *bytes -= framedRecordSize(file, previous);
+            }
+        }
+        if (type == DeleteRecord) {
+            ++*dead;
+            (*target)[id] = {};
+            if (changes && previous >= 0) {
+                HistoryEntry removed;
+                quint8 removedType {};
+                decodeRecord(readFramedRecord(file, previous), &removedType, &removed);
+                removed.id = id;
+                changes->insert(id, {-1, removed});
+            }
+        } else {
+            (*target)[id] = {offset, entry.lastVisit, urlKey(entry.url)};
+            if (bytes) {
+                *bytes += record.size();
+            }
+            if (changes) {
+                changes->insert(id, {offset, entry});
+            }
+        }
+        offset += record.size();
+    }
+    return offset;
+}
+
+// Another process replaced the log by clearing or compacting it. Read the new one and tell the store
+// where its entries are now and which of them differ from what it knew; the old log is still open
+// for reading the entries that were removed.
+void HistoryStore::Writer::reload(int batchGeneration)
+{
+    QFile fresh(log.fileName());
+    if (!fresh.open(QIODevice::ReadWrite)) {
+        qWarning() << "Could not reopen history log" << log.fileName();
+        return;
+    }
+    QList<Slot> freshTable;
+    int dead {};
+    const qint64 end = scan(fresh, logHeaderSize, &freshTable, &dead, nullptr, nullptr);
+    if (end < fresh.size()) {
+        fresh.resize(end);
+    }
+    QList<Synced> changes;
+    const qsizetype count = qMax(table.size(), freshTable.size());
+    for (qsizetype id = 0; id < count; ++id) {
+        const Slot before = table.value(id);
+        const Slot after = freshTable.value(id);
+        quint8 type {};
+        HistoryEntry entry;
+        if (before.offset >= 0 && after.offset < 0) {
+            decodeRecord(readFramedRecord(log, before.offset), &type, &entry);
+            entry.id = static_cast<int>(id);
+            changes.append({-1, entry});
+        } else if (after.offset >= 0
+                   && (before.offset < 0 || before.lastVisit != after.lastVisit || before.urlKey != after.urlKey)
+                   && decodeRecord(readFramedRecord(fresh, after.offset), &type, &entry)) {
+            changes.append({after.offset, entry});
+        }
+    }
+    fresh.close();
+    // Nobody can replace the log again while the lock is held, so reopening by name gets the same file.
+    log.close();
+    if (!log.open(QIODevice::ReadWrite)) {
+        qWarning() << "Could not reopen history log" << log.fileName();
+    }
+    logId = fileId(log);
+    knownSize = log.size();
+    table = freshTable;
+    deadRecords = dead;
+    measure();
+    writeIndex(index, table, log.size(), deadRecords);
+    postReplaced(batchGeneration, changes);
+}
+
+// Tell the store about a new log file, handing it a reader opened while the lock is held.
+void HistoryStore::Writer::postReplaced(int batchGeneration, const QList<Synced> &changes)
+{
+    Sync sync {true, std::make_shared<QFile>(log.fileName()), {}, changes};
+    if (!sync.reader->open(QIODevice::ReadOnly)) {
+        qWarning() << "Could not open history log for reading" << log.fileName();
+    }
+    sync.offsets.reserve(table.size());
+    for (const Slot &slot : std::as_const(table)) {
+        sync.offsets.append(slot.offset);
+    }
+    QMetaObject::invokeMethod(
+        store, [store = store, batchGeneration, sync] { store->synced(batchGeneration, sync); },
+        Qt::QueuedConnection);
+}
+
+// Copy the live records into a new log once enough of the current one is superseded or deleted.
+void HistoryStore::Writer::maybeCompact(int batchGeneration)
+{
+    if (deadRecords < compactionMinDeadRecords || deadRecords * 4 < table.size()) {
+        return;
+    }
+    replaceLog(true, batchGeneration);
+}
+
+// Write a new log with the live records, or with none to clear it, and rename it over the current
+// one. The highest id stays taken by a tombstone, so ids reserved by any process remain unique.
+bool HistoryStore::Writer::replaceLog(bool keepRecords, int batchGeneration)
+{
+    const QString replacementPath = log.fileName() + ".compact";
+    QFile target(replacementPath);
+    if (!target.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        return false;
+    }
+    target.write(fileHeader(logMagic, logVersion));
+    QList<Slot> replacement(table.size());
+    qint64 offset = logHeaderSize;
+    for (qsizetype id = 0; keepRecords && id < table.size(); ++id) {
+        if (table.at(id).offset < 0) {
+            continue;
+        }
+        const QByteArray record = readFramedRecord(log, table.at(id).offset);
+        if (record.isEmpty() || target.write(record) != record.size()) {
+            target.close();
+            QFile::remove(replacementPath);
+            return false;
+        }
+        replacement[id] = {offset, table.at(id).lastVisit, table.at(id).urlKey};
+        offset += record.size();
+    }
+    int dead {};
+    if (!replacement.isEmpty() && replacement.constLast().offset < 0) {
+        target.write(encodeDelete(static_cast<int>(replacement.size() - 1)));
+        ++dead;
+    }
+    const bool ok = target.flush();
+    target.close();
+    if (!ok
+        || std::rename(QFile::encodeName(replacementPath).constData(), QFile::encodeName(log.fileName()).constData())
+               != 0) {
+        qWarning() << "Could not replace history log";
+        QFile::remove(replacementPath);
+        return false;
+    }
+    log.close();
+    if (!log.open(QIODevice::ReadWrite)) {
+        qWarning() << "Could not reopen history log" << log.fileName();
+    }
+    logId = fileId(log);
+    knownSize = log.size();
+    liveBytes = offset - logHeaderSize;
+    table = replacement;
+    deadRecords = dead;
+    writeIndex(index, table, log.size(), deadRecords);
+    postReplaced(batchGeneration, {});
+    return true;
+}
+
+HistoryStore::HistoryStore(QObject *parent)
+    : QObject(parent)
+{
+    expiryTimer.setSingleShot(true);
+    connect(&expiryTimer, &QTimer::timeout, this, &HistoryStore::expire);
+    iconSweepTimer.setSingleShot(true);
+    iconSweepTimer.setInterval(iconSweepDelay);
+    connect(&iconSweepTimer, &QTimer::timeout, this, [this] {
+        if (writer) {
+            writer->collectIcons();
+        }
+    });
+    const QString dataPath = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+    if (!QDir().mkpath(dataPath)) {
+        qWarning() << "Could not create history directory" << dataPath;
+        return;
+    }
+    // Loading may repair or rewrite the files, and the table must match the log opened for reading.
+    const QString lockPath = dataPath + "/history.lock";
+    FileLock lock(lockPath);
+    if (!open(dataPath)) {
+        return;
+    }
+    if (migrateFromSettings()) {
+        mergeDuplicates();
+    }
+    buildLookups();
+    // From here on the writer thread owns the files for writing, this thread only reads the log.
+    index.close();
+    log.close();
+    writer = std::make_unique<Writer>(this, log.fileName(), index.fileName(), lockPath, table, deadRecords);
+    if (!log.open(QIODevice::ReadOnly)) {
+        qWarning() << "Could not open history log" << log.fileName();
+    }
+}
+
+HistoryStore::~HistoryStore()
+{
+    writer.reset();
+    log.close();
+}
+
+HistoryStore *HistoryStore::instance()
+{
+    static auto *store = new HistoryStore(QCoreApplication::instance());
+    return store;
+}
+
+bool HistoryStore::open(const QString &dataPath)
+{
+    log.setFileName(dataPath + "/history.log");
+    index.setFileName(dataPath + "/history.idx");
+    if (!openLog()) {
+        return false;
+    }
+    if (!index.open(QIODevice::ReadWrite)) {
+        qWarning() << "Could not open history index" << index.fileName();
+        return false;
+    }
+    if (!loadIndex()) {
+        // Also the upgrade path from logs with one entry per page load
+        table.clear();
+        rebuildIndex(logHeaderSize);
+        mergeDuplicates();
+    }
+    return true;
+}
+
+bool HistoryStore::openLog()
+{
+    if (!log.open(QIODevice::ReadWrite)) {
+        qWarning() << "Could not open history log" << log.fileName();
+        return false;
+    }
+    if (log.size() == 0) {
+        log.write(fileHeader(logMagic, logVersion));
+        return log.flush();
+    }
+    const QByteArray header = log.read(logHeaderSize);
+    if (header.size() == logHeaderSize && qFromBigEndian<quint32>(header.constData()) == logMagic) {
+        const auto version = qFromBigEndian<quint32>(header.constData() + 4);
+        if (version == logVersion) {
+            return true;
+        }
+        if (version == 1) {
+            return upgradeLog();
+        }
+    }
+    // Keep an unreadable log aside instead of overwriting it, then start a fresh one.
+    qWarning() << "Unrecognized history log format, moving it aside";
+    log.close();
+    QFile::remove(log.fileName() + ".bad");
+    QFile::rename(log.fileName(), log.fileName() + ".bad");
+    if (!log.open(QIODevice::ReadWrite | QIODevice::Truncate)) {
+        return false;
+    }
+    log.write(fileHeader(logMagic, logVersion));
+    return log.flush();
+}
+
+// Version 1 logs kept favicons inline as PNG data, move them to the favicon store.
+bool HistoryStore::upgradeLog()
+{
+    const QString upgradedPath = log.fileName() + ".upgrade";
+    QFile upgraded(upgradedPath);
+    if (!upgraded.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        return false;
+    }
+    upgraded.write(fileHeader(logMagic, logVersion));
+    qint64 offset = logHeaderSize;
+    while (offset < log.size()) {
+        QByteArray record = readFramedRecord(log, offset);
+        quint8 type {};
+        HistoryEntry entry;
+        if (record.isEmpty() || !decodeRecord(record, &type, &entry)) {
+            break;
+        }
+        offset += record.size();
+        if (type == EntryRecord && !entry.iconRef.isEmpty() && !FaviconStore::isReference(entry.iconRef)) {
+            entry.iconRef = FaviconStore::instance()->addPng(entry.iconRef, QUrl(entry.url).host());
+            record = encodeEntry(entry);
+        }
+        upgraded.write(record);
+    }
+    if (!upgraded.flush()) {
+        upgraded.close();
+        QFile::remove(upgradedPath);
+        return false;
+    }
+    upgraded.close();
+    log.close();
+    if (std::rename(QFile::encodeName(upgradedPath).constData(), QFile::encodeName(log.fileName()).constData())
+        != 0) {
+        qWarning() << "Could not upgrade history log" << log.fileName();
+        return false;
+    }
+    // Offsets changed, the index is rebuilt from the upgraded log
+    QFile::remove(index.fileName());
+    return log.open(QIODevice::ReadWrite);
+}
+
+// Load the slot table; records appended after the index was last written are picked up from the log tail.
+bool HistoryStore::loadIndex()
+{
+    index.seek(0);
+    const QByteArray header = index.read(indexHeaderSize);
+    if (header.size() != indexHeaderSize || qFromBigEndian<quint32>(header.constData()) != indexMagic
+        || qFromBigEndian<quint32>(header.constData() + 4) != indexVersion) {
+        return false;
+    }
+    const auto indexedLogSize = qFromBigEndian<qint64>(header.constData() + 8);
+    if (indexedLogSize < logHeaderSize || indexedLogSize > log.size()) {
+        return false;
+    }
+    deadRecords = static_cast<int>(qFromBigEndian<quint32>(header.constData() + 16));
+    table = readIndexTable(index);
+    if (indexedLogSize < log.size()) {
+        rebuildIndex(indexedLogSize);
+    }
+    return true;
+}
+
+// Scan the log from the given offset and record the latest offset of every entry.
+// A torn record at the end (e.g. after a crash) is cut off.
+void HistoryStore::rebuildIndex(qint64 from)
+{
+    if (from == logHeaderSize) {
+        deadRecords = 0;
+    }
+    qint64 offset = from;
+    while (offset < log.size()) {
+        const QByteArray record = readFramedRecord(log, offset);
+        quint8 type {};
+        HistoryEntry entry;
+        if (record.isEmpty() || !decodeRecord(record, &type, &entry)) {
+            break;
+        }
+        if (entry.id >= table.size()) {
+            table.resize(entry.id + 1);
+        }
+        if (table.at(entry.id).offset >= 0) {
+            ++deadRecords;
+        }
+        if (type == DeleteRecord) {
+            ++deadRecords;
+            table[entry.id] = {};
+        } else {
+            table[entry.id] = {offset, entry.lastVisit, urlKey(entry.url)};
+        }
+        offset += record.size();
+    }
+    if (offset < log.size()) {
+        qWarning() << "Truncating damaged history log at" << offset;
+        log.resize(offset);
+    }
+    writeIndex(index, table, log.size(), deadRecords);
+}
+
+// Fold entries sharing a URL, as left by versions that added an entry for every page load, into the
+// newest of them.
+void HistoryStore::mergeDuplicates()
+{
+    QHash<QString, int> keepers;
+    QList<HistoryEntry> merged;
+    QHash<int, qsizetype> mergedIndex;
+    QList<int> removed;
+    for (int id = static_cast<int>(table.size()) - 1; id >= 0; --id) {
+        HistoryEntry current;
+        if (table.at(id).offset < 0 || !readEntry(table.at(id).offset, &current)) {
+            continue;
+        }
+        const auto keeper = keepers.constFind(current.url);
+        if (keeper == keepers.constEnd()) {
+            keepers.insert(current.url, id);
+            continue;
+        }
+        auto position = mergedIndex.constFind(keeper.value());
+        if (position == mergedIndex.constEnd()) {
+            HistoryEntry newest;
+            readEntry(table.at(keeper.value()).offset, &newest);
+            position = mergedIndex.insert(keeper.value(), merged.size());
+            merged.append(newest);
+        }
+        mergeEntry(&merged[position.value()], current);
+        removed.append(id);
+    }
+    if (merged.isEmpty()) {
+        return;
+    }
+    QByteArray data;
+    const qint64 base = log.size();
+    for (const HistoryEntry &entry : std::as_const(merged)) {
+        table[entry.id] = {base + data.size(), entry.lastVisit, urlKey(entry.url)};
+        data += encodeEntry(entry);
+    }
+    for (const int id : std::as_const(removed)) {
+        data += encodeDelete(id);
+        table[id] = {};
+    }
+    if (writeRecord(log, data) < 0) {
+        log.resize(base);
+        table.clear();
+        rebuildIndex(logHeaderSize);
+        return;
+    }
+    deadRecords += static_cast<int>(merged.size() + removed.size() * 2);
+    writeIndex(index, table, log.size(), deadRecords);
+}
+
+// Entries are found by URL hash and listed by last visit from memory.
+void HistoryStore::buildLookups()
+{
+    urlIds.clear();
+    recency.clear();
+    for (qsizetype id = 0; id < table.size(); ++id) {
+        const Slot &slot = table.at(id);
+        if (slot.offset >= 0) {
+            urlIds.insert(slot.urlKey, static_cast<int>(id));
+            recency.insert({slot.lastVisit, static_cast<int>(id)});
+        }
+    }
+}
+
+// Slots of ids that were never written read back as zero and are treated as empty.
+QList<HistoryStore::Slot> HistoryStore::readIndexTable(QFile &file)
+{
+    file.seek(indexHeaderSize);
+    const QByteArray data = file.readAll();
+    QList<Slot> result(data.size() / indexSlotSize);
+    for (qsizetype i = 0; i < result.size(); ++i) {
+        const char *slot = data.constData() + i * indexSlotSize;
+        const auto offset = qFromBigEndian<qint64>(slot);
+        if (offset >= logHeaderSize) {
+            result[i] = {offset, qFromBigEndian<qint64>(slot + 8), qFromBigEndian<quint64>(slot + 16)};
+        }
+    }
+    return result;
+}
+
+void HistoryStore::writeIndex(QFile &file, const QList<Slot> &table, qint64 logSize, int deadRecords)
+{
+    QByteArray data(table.size() * indexSlotSize, Qt::Uninitialized);
+    for (qsizetype i = 0; i < table.size(); ++i) {
+        char *slot = data.data() + i * indexSlotSize;
+        qToBigEndian<qint64>(table.at(i).offset, slot);
+        qToBigEndian<qint64>(table.at(i).lastVisit, slot + 8);
+        qToBigEndian<quint64>(table.at(i).urlKey, slot + 16);
+    }
+    file.resize(indexHeaderSize);
+    file.seek(indexHeaderSize);
+    file.write(data);
+    writeIndexHeader(file, logSize, deadRecords);
+}
+
+void HistoryStore::writeIndexSlot(QFile &file, int id, const Slot &slot)
+{
+    QByteArray data(indexSlotSize, Qt::Uninitialized);
+    qToBigEndian<qint64>(slot.offset, data.data());
+    qToBigEndian<qint64>(slot.lastVisit, data.data() + 8);
+    qToBigEndian<quint64>(slot.urlKey, data.data() + 16);
+    file.seek(indexHeaderSize + qint64(id) * indexSlotSize);
+    file.write(data);
+}
+
+void HistoryStore::writeIndexHeader(QFile &file, qint64 logSize, int deadRecords)
+{
+    QByteArray header = fileHeader(indexMagic, indexVersion);
+    header.resize(indexHeaderSize);
+    qToBigEndian<qint64>(logSize, header.data() + 8);
+    qToBigEndian<quint32>(static_cast<quint32>(deadRecords), header.data() + 16);
+    qToBigEndian<quint32>(0, header.data() + 20);
+    file.seek(0);
+    file.write(header);
+    file.flush();
+}
+
+qint64 HistoryStore::writeRecord(QFile &file, const QByteArray &record)
+{
+    const qint64 offset = file.size();
+    if (!file.seek(offset) || file.write(record) != record.size() || !file.flush()) {
+        qWarning() << "Could not write history record to" << file.fileName();
+        return -1;
+    }
+    return offset;
+}
+
+bool HistoryStore::readEntry(qint64 offset, HistoryEntry *entry) const
+{
+    if (offset < logHeaderSize) {
+        return false;
+    }
+    const QByteArray record = readFramedRecord(reader ? *reader : log, offset);
+    quint8 type {};
+    return !record.isEmpty() && decodeRecord(record, &type, entry) && type == EntryRecord;
+}
+
+// Visiting a URL already in history updates its entry instead of adding one. Changed entries are
+// readable from memory until the writer reports where they were written. The log is never read
+// here: an entry that is only on disk gets the visit added by the writer, and listeners hear of it
+// once it is written.
+int HistoryStore::recordVisit(const QString &url, const QString &title)
+{
+    if (!writer) {
+        return -1;
+    }
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    const quint64 key = urlKey(url);
+    for (auto it = urlIds.constFind(key); it != urlIds.constEnd() && it.key() == key; ++it) {
+        const auto changed = pending.constFind(it.value());
+        if (changed == pending.constEnd()) {
+            HistoryEntry visit;
+            visit.id = it.value();
+            visit.url = url;
+            visit.title = title;
+            Slot &slot = table[visit.id];
+            recency.erase({slot.lastVisit, visit.id});
+            recency.insert({now, visit.id});
+            slot.lastVisit = now;
+            writer->visit(visit, now, ++sequence);
+            return visit.id;
+        }
+        HistoryEntry visited = changed->entry;
+        if (visited.url != url) {
+            continue;
+        }
+        ++visited.visitCount;
+        if (!title.isEmpty()) {
+            visited.title = title;
+        }
+        visited.lastVisit = now;
+        visited.visits.append(now);
+        if (visited.visits.size() > HistoryEntry::maxVisits) {
+            visited.visits.removeFirst();
+        }
+        update(visited, now);
+        emit entryVisited(visited);
+        return visited.id;
+    }
+    HistoryEntry entry;
+    entry.id = allocateId();
+    entry.url = url;
+    entry.title = title;
+    entry.firstVisit = now;
+    entry.lastVisit = now;
+    entry.visits = {now};
+    table[entry.id] = {pendingOffset, now, key};
+    urlIds.insert(key, entry.id);
+    recency.insert({now, entry.id});
+    pending.insert(entry.id, {entry, ++sequence});
+    writer->add(entry, sequence);
+    emit entryAdded(entry);
+    if (static_cast<int>(recency.size()) > entryLimit() && !expiryTimer.isActive()) {
+        expiryTimer.start(0);
+    }
+    return entry.id;
+}
+
+// Ids come from blocks the writer reserved in the log. When no block is ready, the id after the
+// highest one known is used provisionally; the writer stores the entry under an id of its own if
+// another process may hold that one. Ids of a block already used that way are skipped.
+int HistoryStore::allocateId()
+{
+    while (nextId < table.size() && table.at(nextId).offset != -1) {
+        ++nextId;
+    }
+    if (nextId >= idLimit) {
+        const auto [first, count] = writer->takeIds();
+        if (count > 0) {
+            nextId = first;
+            idLimit = first + count;
+            while (nextId < qMin<qsizetype>(idLimit, table.size()) && table.at(nextId).offset != -1) {
+                ++nextId;
+            }
+        }
+        if (nextId >= idLimit) {
+            nextId = qMax(nextId, static_cast<int>(table.size()));
+            idLimit = nextId + 1;
+        }
+    }
+    const int id = nextId++;
+    if (id >= table.size()) {
+        table.resize(id + 1);
+    }
+    return id;
+}
+
+// Queue a visit to a changed entry and move it to its new place in the recency order. The visit is
+// written as such, so it adds to visits other processes recorded meanwhile instead of replacing them.
+void HistoryStore::update(const HistoryEntry &entry, qint64 visit)
+{
+    Slot &slot = table[entry.id];
+    recency.erase({slot.lastVisit, entry.id});
+    recency.insert({entry.lastVisit, entry.id});
+    slot.lastVisit = entry.lastVisit;
+    pending.insert(entry.id, {entry, ++sequence});
+    writer->visit(entry, visit, sequence);
+}
+
+void HistoryStore::setIcon(int id, const QByteArray &iconRef)
+{
+    if (!writer || id < 0 || id >= table.size() || table.at(id).offset == -1) {
+        return;
+    }
+    auto it = pending.find(id);
+    if (it != pending.end() && it->entry.iconRef == iconRef) {
+        return;
+    }
+    ++sequence;
+    if (it != pending.end()) {
+        it->entry.iconRef = iconRef;
+        it->sequence = sequence;
+    }
+    writer->setIcon(id, iconRef, sequence);
+}
+
+// Drop an entry from memory and let the listeners know.
+void HistoryStore::forget(const HistoryEntry &removed)
+{
+    Slot &slot = table[removed.id];
+    urlIds.remove(slot.urlKey, removed.id);
+    recency.erase({slot.lastVisit, removed.id});
+    slot = {};
+    pending.remove(removed.id);
+    emit entryRemoved(removed);
+}
+
+// Deleting only appends a tombstone and clears the index slot; the space is reclaimed by compaction.
+bool HistoryStore::remove(int id)
+{
+    const HistoryEntry removed = entry(id);
+    if (!writer || !removed.isValid()) {
+        return false;
+    }
+    writer->remove(id);
+    forget(removed);
+    if (!iconSweepTimer.isActive()) {
+        iconSweepTimer.start();
+    }
+    return true;
+}
+
+// Ids stay taken, so they remain unique across processes and the ids reserved so far stay usable.
+void HistoryStore::clear()
+{
+    // Results of batches still in flight describe the old history and are ignored.
+    ++generation;
+    table = QList<Slot>(table.size());
+    urlIds.clear();
+    recency.clear();
+    pending.clear();
+    if (writer) {
+        writer->clear(generation);
+        liveBytes = 0;
+    }
+    iconSweepTimer.stop();
+    FaviconStore::instance()->sweep({}, {}, false);
+    emit cleared();
+    // Range removals in progress have nothing left to do.
+    const QList<RangeRemoval> removals = std::exchange(rangeRemovals, {});
+    for (const RangeRemoval &removal : removals) {
+        emit rangeRemoved(removal.from, removal.to);
+    }
+}
+
+// Remove the visits made in [from, to) and the entries left without visits. The writer does it on
+// the latest records under the lock, so visits other processes recorded meanwhile are kept;
+// rangeRemoved() is emitted when it is done.
+void HistoryStore::removeRange(qint64 from, qint64 to)
+{
+    if (!writer || from >= to) {
+        emit rangeRemoved(from, to);
+        return;
+    }
+    rangeRemovals.append({from, to});
+    writer->removeVisits(from, to);
+}
+
+// Take over what the writer removed for range removals. Changes still queued for an entry get the
+// same visits taken out, they are written as visits added to the trimmed record.
+void HistoryStore::trimmed(int batchGeneration, const QList<std::pair<qint64, qint64>> &removals,
+                           const QList<Trimmed> &changes)
+{
+    // Cleared meanwhile, clear() reported the ranges as done.
+    if (batchGeneration != generation) {
+        return;
+    }
+    for (const Trimmed &change : changes) {
+        const int id = change.before.id;
+        if (id >= table.size() || table.at(id).offset == -1) {
+            continue;
+        }
+        if (change.offset < 0) {
+            forget(change.before);
+            continue;
+        }
+        HistoryEntry after = change.after;
+        auto it = pending.find(id);
+        if (it != pending.end()) {
+            for (const auto &[from, to] : removals) {
+                dropVisits(&it->entry, from, to);
+            }
+            after = it->entry;
+        }
+        Slot &slot = table[id];
+        recency.erase({slot.lastVisit, id});
+        slot.offset = change.offset;
+        slot.lastVisit = after.lastVisit;
+        recency.insert({slot.lastVisit, id});
+        emit visitsRemoved(change.before, after);
+    }
+    for (const std::pair<qint64, qint64> &range : removals) {
+        const auto done = std::find_if(rangeRemovals.cbegin(), rangeRemovals.cend(), [&range](const RangeRemoval &r) {
+            return r.from == range.first && r.to == range.second;
+        });
+        if (done != rangeRemovals.cend()) {
+            rangeRemovals.erase(done);
+            emit rangeRemoved(range.first, range.second);
+        }
+    }
+}
+
+void HistoryStore::setRetention(const Retention &retention)
+{
+    this->retention = retention;
+    expiryTimer.start(0);
+}
+
+qint64 HistoryStore::diskUsage() const
+{
+    if (liveBytes < 0) {
+        return -1;
+    }
+    return logHeaderSize + liveBytes + indexHeaderSize + table.size() * indexSlotSize;
+}
+
+// The writer reports the size of the live records after every batch.
+void HistoryStore::measured(int batchGeneration, qint64 bytes)
+{
+    if (batchGeneration != generation) {
+        return;
+    }
+    liveBytes = bytes;
+    if (retention.maxBytes > 0 && diskUsage() > retention.maxBytes && !expiryTimer.isActive()) {
+        expiryTimer.start(0);
+    }
+}
+
+// Entries not written yet may use icons the writer did not see.
+void HistoryStore::iconsCollected(int batchGeneration, QSet<QByteArray> refs, QSet<QString> hosts)
+{
+    if (batchGeneration != generation) {
+        return;
+    }
+    for (const Pending &change : std::as_const(pending)) {
+        refs.insert(change.entry.iconRef);
+        hosts.insert(QUrl(change.entry.url).host());
+    }
+    FaviconStore::instance()->sweep(refs, hosts, true);
+}
+
+// The entry count and size limits as one number of entries, the size limit by the average entry size.
+int HistoryStore::entryLimit() const
+{
+    int limit = retention.maxEntries > 0 ? retention.maxEntries : std::numeric_limits<int>::max();
+    const auto entries = static_cast<qint64>(recency.size());
+    if (retention.maxBytes > 0 && liveBytes > 0 && entries > 0) {
+        const qint64 perEntry = liveBytes / entries + indexSlotSize;
+        const qint64 available = retention.maxBytes - logHeaderSize - indexHeaderSize;
+        limit = static_cast<int>(qBound<qint64>(0, available / perEntry, limit));
+    }
+    return limit;
+}
+
+// Remove a batch of the least recently visited entries that are over the limits, then come back
+// for more on the next pass of the event loop. Checked again hourly for entries that aged out.
+void HistoryStore::expire()
+{
+    if (!writer) {
+        return;
+    }
+    const int limit = entryLimit();
+    const qint64 cutoff = retention.maxAgeDays > 0
+                              ? QDateTime::currentMSecsSinceEpoch() - qint64(retention.maxAgeDays) * 24 * 60 * 60 * 1000
+                              : 0;
+    // An entry whose record cannot be read is only dropped from the ordering, so the loop moves on.
+    const auto expireEntry = [this](std::set<std::pair<qint64, int>>::iterator it) {
+        if (!remove(it->second)) {
+            recency.erase(it);
+        }
+    };
+    for (int removed = 0; removed < expiryBatchSize; ++removed) {
+        if (static_cast<int>(recency.size()) > limit) {
+            expireEntry(recency.begin());
+            continue;
+        }
+        // Entries recorded before visits were timed have a last visit of zero and are skipped
+        const auto oldest = recency.lower_bound({1, 0});
+        if (oldest == recency.end() || oldest->first >= cutoff) {
+            expiryTimer.start(expiryCheckInterval);
+            return;
+        }
+        expireEntry(oldest);
+    }
+    expiryTimer.start(0);
+}
+
+void HistoryStore::flush()
+{
+    if (writer) {
+        writer->flush();
+    }
+}
+
+void HistoryStore::written(int batchGeneration, const QList<Written> &records)
+{
+    if (batchGeneration != generation) {
+        return;
+    }
+    for (const Written &record : records) {
+        // Deleted meanwhile
+        if (record.id >= table.size() || table.at(record.id).offset == -1) {
+            continue;
+        }
+        Slot &slot = table[record.id];
+        slot.offset = record.offset;
+        auto it = pending.find(record.id);
+        if (it != pending.end()) {
+            if (it->sequence <= record.sequence) {
+                pending.erase(it);
+            }
+            continue;
+        }
+        // A visit only the writer applied, see recordVisit().
+        if (record.counted) {
+            recency.erase({slot.lastVisit, record.id});
+            slot.lastVisit = record.entry.lastVisit;
+            recency.insert({slot.lastVisit, record.id});
+            emit entryVisited(record.entry);
+        }
+    }
+}
+
+// Apply what other processes wrote, as found by the writer before its last batch. Entries with a
+// local change still queued are left alone, the change is written on top of their latest record.
+void HistoryStore::synced(int batchGeneration, const Sync &sync)
+{
+    // A replaced log is read from now on whatever the generation, so offsets must match it.
+    if (sync.replaced) {
+        for (qsizetype id = 0; id < table.size(); ++id) {
+            if (table.at(id).offset >= 0) {
+                table[id].offset = sync.offsets.value(id, -1);
+            }
+        }
+        reader = sync.reader;
+    }
+    if (batchGeneration != generation) {
+        return;
+    }
+    qsizetype removals {};
+    for (const Synced &change : sync.changes) {
+        if (change.offset >= 0) {
+            removals = -1;
+            break;
+        }
+        const int id = change.entry.id;
+        if (id < table.size() && table.at(id).offset != -1) {
+            ++removals;
+        }
+    }
+    // Cleared by another process: one reset instead of a signal per entry.
+    if (removals > 0 && removals == static_cast<qsizetype>(recency.size())) {
+        for (const Synced &change : sync.changes) {
+            if (change.entry.id < table.size()) {
+                table[change.entry.id] = {};
+            }
+        }
+        urlIds.clear();
+        recency.clear();
+        pending.clear();
+        emit cleared();
+        return;
+    }
+    for (const Synced &change : sync.changes) {
+        const int id = change.entry.id;
+        if (change.offset < 0) {
+            if (id < table.size() && table.at(id).offset != -1) {
+                forget(change.entry);
+            }
+            continue;
+        }
+        applySynced(change);
+    }
+    if (static_cast<int>(recency.size()) > entryLimit() && !expiryTimer.isActive()) {
+        expiryTimer.start(0);
+    }
+}
+
+// Take over an entry as written by the writer, unless a local change to it is still queued.
+void HistoryStore::applySynced(const Synced &change)
+{
+    const int id = change.entry.id;
+    if (pending.contains(id)) {
+        return;
+    }
+    if (id >= table.size()) {
+        table.resize(id + 1);
+    }
+    Slot &slot = table[id];
+    const bool known = slot.offset != -1;
+    if (known) {
+        urlIds.remove(slot.urlKey, id);
+        recency.erase({slot.lastVisit, id});
+    }
+    slot = {change.offset, change.entry.lastVisit, urlKey(change.entry.url)};
+    urlIds.insert(slot.urlKey, id);
+    recency.insert({slot.lastVisit, id});
+    if (known) {
+        emit entryVisited(change.entry);
+    } else {
+        emit entryAdded(change.entry);
+    }
+}
+
+// Entries the writer stored under another id than they were added with are dropped under the old
+// one. Changes made under the old id meanwhile are applied to the new one by the writer.
+void HistoryStore::moved(int batchGeneration, const QList<Moved> &moves)
+{
+    if (batchGeneration != generation) {
+        return;
+    }
+    for (const Moved &move : moves) {
+        if (move.from < table.size() && table.at(move.from).offset != -1) {
+            HistoryEntry old = pending.value(move.from).entry;
+            old.id = move.from;
+            forget(old);
+        }
+        if (move.displaced.offset >= 0) {
+            applySynced(move.displaced);
+        }
+        applySynced(move.to);
+    }
+}
+
+int HistoryStore::size() const
+{
+    return static_cast<int>(table.size());
+}
+
+HistoryEntry HistoryStore::entry(int id) const
+{
+    if (id < 0 || id >= table.size()) {
+        return {};
+    }
+    const auto it = pending.constFind(id);
+    if (it != pending.constEnd()) {
+        return it->entry;
+    }
+    HistoryEntry result;
+    if (table.at(id).offset < 0 || !readEntry(table.at(id).offset, &result)) {
+        return {};
+    }
+    return result;
+}
+
+HistoryStore::Position HistoryStore::position(int id) const
+{
+    if (id < 0 || id >= table.size()) {
+        return {};
+    }
+    return {table.at(id).lastVisit, id};
+}
+
+// Up to limit ids of the entries visited before the given position and not before since, most
+// recent first.
+QList<int> HistoryStore::recentIds(const Position &before, int limit, qint64 since) const
+{
+    QList<int> result;
+    auto it = recency.lower_bound({before.lastVisit, before.id});
+    while (it != recency.begin() && result.size() < limit) {
+        --it;
+        if (it->first < since) {
+            break;
+        }
+        result.append(it->second);
+    }
+    return result;
+}
+
+// Taken from what this thread already knows, without waiting for the writer: entries written so
+// far are read from the log this thread reads, the others are copied from memory. The log is
+// reopened through its descriptor so the snapshot reads the same file even if it is replaced.
+HistoryStore::Snapshot HistoryStore::snapshot() const
+{
+    const QFile &file = reader ? *reader : log;
+    if (!writer || !file.isOpen()) {
+        return {};
+    }
+    Snapshot result;
+    result.log = std::make_shared<QFile>(QStringLiteral("/proc/self/fd/%1").arg(file.handle()));
+    if (!result.log->open(QIODevice::ReadOnly)) {
+        qWarning() << "Could not open history log for reading" << file.fileName();
+        return {};
+    }
+    result.size = result.log->size();
+    result.offsets.reserve(table.size());
+    for (qsizetype id = 0; id < table.size(); ++id) {
+        result.offsets.append(pending.contains(static_cast<int>(id)) ? -1 : table.at(id).offset);
+    }
+    result.pending.reserve(pending.size());
+    for (const Pending &change : pending) {
+        result.pending.append(change.entry);
+    }
+    return result;
+}
+
+// Read the log sequentially and pass every live entry of the snapshot to visit, in log order, then
+// the entries that were not written yet.
+void HistoryStore::forEachEntry(const Snapshot &snapshot, const std::function<void(const HistoryEntry &)> &visit)
+{
+    if (!snapshot.log || !snapshot.log->isOpen()) {
+        return;
+    }
+    qint64 offset = logHeaderSize;
+    while (offset < snapshot.size) {
+        const QByteArray record = readFramedRecord(*snapshot.log, offset);
+        quint8 type {};
+        HistoryEntry entry;
+        if (record.isEmpty() || !decodeRecord(record, &type, &entry)) {
+            break;
+        }
+        if (type == EntryRecord && snapshot.offsets.value(entry.id, -1) == offset) {
+            visit(entry);
+        }
+        offset += record.size();
+    }
+    for (const HistoryEntry &entry : snapshot.pending) {
+        visit(entry);
+    }
+}
+
+// Move the history kept by older versions in the settings file into the store.
+bool HistoryStore::migrateFromSettings()
+{
+    QSettings *settings = Settings::instance()->store();
+    const int count = settings->beginReadArray("History");
+    if (count == 0) {
+        settings->endArray();
+        return false;
+    }
+    for (int i = 0; i < count; ++i) {
+        settings->setArrayIndex(i);
+        HistoryEntry entry;
+        entry.url = settings->value("url").toString();
+        if (entry.url.isEmpty()) {
+            continue;
+        }
+        entry.id = static_cast<int>(table.size());
+        entry.title = settings->value("title").toString();
+        entry.iconRef = FaviconStore::instance()->addPng(settings->value("icon").toByteArray(),
+                                                          QUrl(entry.url).host());
+        const qint64 offset = writeRecord(log, encodeEntry(entry));
+        if (offset < 0) {
+            break;
+        }
+        table.append({offset, entry.lastVisit, urlKey(entry.url)});
+    }
+    settings->endArray();
+    writeIndex(index, table, log.size(), deadRecords);
+    settings->remove("History");
+    return true;
+}
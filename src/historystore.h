@@ -0,0 +1,250 @@
+/*****************************************************************************
+ * historystore.h
+ *****************************************************************************
+ * Copyright (C) 2026 MX Authors
+ *
+ * Authors: Adrian <adrian@mxlinux.org>
+ *          MX Linux <http://mxlinux.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MX Viewer is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MX Viewer.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#pragma once
+
+#include <QByteArray>
+#include <QFile>
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QSet>
+#include <QString>
+#include <QTimer>
+
+#include <functional>
+#include <limits>
+#include <memory>
+#include <set>
+#include <utility>
+
+// One entry per URL. Times are milliseconds since the epoch, zero for entries
+// recorded before visits were counted.
+struct HistoryEntry {
+    int id {-1};
+    QString title;
+    QString url;
+    QByteArray iconRef;
+    int visitCount {1};
+    qint64 firstVisit {};
+    qint64 lastVisit {};
+    QList<qint64> visits; // Times of the latest visits, at most maxVisits
+
+    static constexpr qsizetype maxVisits {10};
+
+    [[nodiscard]] bool isValid() const { return id >= 0 && !url.isEmpty(); }
+};
+
+// History is kept in an append-only log of entry records plus a compact index
+// holding the log offset of the latest record for every entry id, along with
+// its last visit time and URL hash. Visiting a URL again updates its entry.
+// Appends, deletes (tombstones) and lookups by id or URL are O(1); the index is
+// only a cache and is rebuilt from the log when it is missing or stale. Entry
+// ids are stable.
+//
+// Changes take effect in memory right away and are written by a worker thread
+// in batches, so recording a visit never waits for the disk. Superseded and
+// deleted records are reclaimed by compaction on the same thread.
+//
+// Several processes can share the store. Writes are serialized by a file
+// lock, each process picks up the others' records before writing its own and
+// emits the usual signals for them, and ids are reserved in blocks so they
+// stay unique across processes.
+//
+// Entries beyond the retention limits are expired least recently visited
+// first, a small batch per event loop pass; removing the visits of a time
+// range runs the same way. The recency order doubles as the time index for
+// range queries. Some time after entries were deleted, the writer collects the
+// favicons and hosts the remaining ones use so the favicon store can drop the
+// rest.
+class HistoryStore : public QObject
+{
+    Q_OBJECT
+
+public:
+    static HistoryStore *instance();
+    ~HistoryStore() override;
+
+    int recordVisit(const QString &url, const QString &title);
+    void setIcon(int id, const QByteArray &iconRef);
+    bool remove(int id);
+    void removeRange(qint64 from, qint64 to);
+    void clear();
+    void flush();
+
+    // Zero means no limit. Entries without visit times never expire by age.
+    struct Retention {
+        int maxEntries {};
+        int maxAgeDays {};
+        qint64 maxBytes {};
+    };
+    void setRetention(const Retention &retention);
+    // Size of the live records and the index, what the files shrink to on compaction; -1 until known.
+    [[nodiscard]] qint64 diskUsage() const;
+
+    [[nodiscard]] int size() const;
+    [[nodiscard]] HistoryEntry entry(int id) const;
+
+    // Place of an entry in the list of entries by last visit; the default is before the newest.
+    struct Position {
+        qint64 lastVisit {std::numeric_limits<qint64>::max()};
+        int id {};
+    };
+    [[nodiscard]] Position position(int id) const;
+    [[nodiscard]] QList<int> recentIds(const Position &before, int limit,
+                                       qint64 since = std::numeric_limits<qint64>::min()) const;
+
+    // A consistent view of the history that can be read on another thread. The log
+    // file is opened up front, so it stays valid if compaction replaces the log.
+    // Entries not written yet are copied in pending. Taking one never blocks.
+    struct Snapshot {
+        std::shared_ptr<QFile> log;
+        qint64 size {};
+        QList<qint64> offsets;
+        QList<HistoryEntry> pending;
+    };
+    [[nodiscard]] Snapshot snapshot() const;
+    static void forEachEntry(const Snapshot &snapshot, const std::function<void(const HistoryEntry &)> &visit);
+
+signals:
+    void entryAdded(const HistoryEntry &entry);
+    void entryVisited(const HistoryEntry &entry);
+    void entryRemoved(const HistoryEntry &entry);
+    void visitsRemoved(const HistoryEntry &before, const HistoryEntry &after);
+    void rangeRemoved(qint64 from, qint64 to);
+    void cleared();
+
+private:
+    explicit HistoryStore(QObject *parent = nullptr);
+
+    class Writer;
+    // Where a change was written. Counted ones added visits the store did not apply itself; they
+    // come with the record as written.
+    struct Written {
+        int id {};
+        qint64 offset {};
+        quint64 sequence {};
+        HistoryEntry entry;
+        bool counted {};
+    };
+    // Entries not yet written by the writer thread, with the sequence number of their latest change.
+    struct Pending {
+        HistoryEntry entry;
+        quint64 sequence {};
+    };
+
+    struct RangeRemoval {
+        qint64 from {};
+        qint64 to {};
+    };
+
+    struct Slot {
+        qint64 offset {-1};
+        qint64 lastVisit {};
+        quint64 urlKey {};
+    };
+    // An entry written or removed by another process; removed ones have an offset of -1.
+    struct Synced {
+        qint64 offset {-1};
+        HistoryEntry entry;
+    };
+    // An entry the writer stored under another id than it was added with. Displaced is the entry of
+    // another process that held the old id, if any.
+    struct Moved {
+        int from {};
+        Synced to;
+        Synced displaced;
+    };
+    // An entry that lost visits to a range removal; removed ones have an offset of -1.
+    struct Trimmed {
+        qint64 offset {-1};
+        HistoryEntry before;
+        HistoryEntry after;
+    };
+    // What the writer found under the lock. A replaced log comes with a reader opened on the new
+    // file and the offsets of every entry in it.
+    struct Sync {
+        bool replaced {};
+        std::shared_ptr<QFile> reader;
+        QList<qint64> offsets;
+        QList<Synced> changes;
+    };
+
+    mutable QFile log;
+    std::shared_ptr<QFile> reader; // The log as replaced by the writer, read instead of log once set
+    QFile index;
+    QList<Slot> table;
+    QMultiHash<quint64, int> urlIds;
+    std::set<std::pair<qint64, int>> recency;
+    QHash<int, Pending> pending;
+    quint64 sequence {};
+    int nextId {};
+    int idLimit {};
+    int generation {};
+    int deadRecords {};
+    std::unique_ptr<Writer> writer;
+    Retention retention;
+    QTimer expiryTimer;
+    QList<RangeRemoval> rangeRemovals;
+    QTimer iconSweepTimer;
+    qint64 liveBytes {-1};
+
+    static constexpr quint32 logMagic {0x4d58484c};   // "MXHL"
+    static constexpr quint32 indexMagic {0x4d584849}; // "MXHI"
+    static constexpr quint32 logVersion {2};
+    static constexpr quint32 indexVersion {3};
+    static constexpr qint64 logHeaderSize {8};
+    static constexpr qint64 indexHeaderSize {24};
+    static constexpr qint64 indexSlotSize {24};
+    static constexpr qint64 pendingOffset {-2};
+    static constexpr int expiryBatchSize {200};
+    static constexpr int expiryCheckInterval {60 * 60 * 1000};
+    static constexpr int iconSweepDelay {10000};
+
+    bool open(const QString &dataPath);
+    bool openLog();
+    bool upgradeLog();
+    bool loadIndex();
+    void rebuildIndex(qint64 from);
+    bool migrateFromSettings();
+    void mergeDuplicates();
+    void buildLookups();
+    bool readEntry(qint64 offset, HistoryEntry *entry) const;
+    void written(int batchGeneration, const QList<Written> &records);
+    void synced(int batchGeneration, const Sync &sync);
+    void applySynced(const Synced &change);
+    void moved(int batchGeneration, const QList<Moved> &moves);
+    void forget(const HistoryEntry &entry);
+    [[nodiscard]] int allocateId();
+    void update(const HistoryEntry &entry, qint64 visit);
+    void trimmed(int batchGeneration, const QList<std::pair<qint64, qint64>> &removals,
+                 const QList<Trimmed> &changes);
+    void measured(int batchGeneration, qint64 bytes);
+    void iconsCollected(int batchGeneration, QSet<QByteArray> refs, QSet<QString> hosts);
+    [[nodiscard]] int entryLimit() const;
+    void expire();
+
+    static qint64 writeRecord(QFile &file, const QByteArray &record);
+    static QList<Slot> readIndexTable(QFile &file);
+    static void writeIndex(QFile &file, const QList<Slot> &table, qint64 logSize, int deadRecords);
+    static void writeIndexSlot(QFile &file, int id, const Slot &slot);
+    static void writeIndexHeader(QFile &file, qint64 logSize, int deadRecords);
+};
@@ -0,0 +1,175 @@
+/*****************************************************************************
+ * hosttrie.cpp
+ *****************************************************************************
+ * Copyright (C) 2026 MX Authors
+ *
+ * Authors: Adrian <adrian@mxlinux.org>
+ *          MX Linux <http://mxlinux.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MX Viewer is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MX Viewer.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#include "hosttrie.h"
+
+#include <algorithm>
+#include <cmath>
+
+HostTrie::HostTrie()
+{
+    clear();
+}
+
+void HostTrie::clear()
+{
+    nodes.clear();
+    nodes.append(Node {});
+}
+
+int HostTrie::child(int node, char16_t key) const
+{
+    for (const auto &[childKey, index] : nodes.at(node).children) {
+        if (childKey == key) {
+            return index;
+        }
+    }
+    return -1;
+}
+
+int HostTrie::find(const QString &key) const
+{
+    int node = 0;
+    for (const QChar c : key) {
+        node = child(node, c.unicode());
+        if (node < 0) {
+            break;
+        }
+    }
+    return node;
+}
+
+// Higher score wins, then the shorter host.
+bool HostTrie::isBetter(int candidate, int current) const
+{
+    if (candidate < 0) {
+        return false;
+    }
+    if (current < 0) {
+        return true;
+    }
+    const Node &a = nodes.at(candidate);
+    const Node &b = nodes.at(current);
+    if (a.score != b.score) {
+        return a.score > b.score;
+    }
+    return a.host.size() < b.host.size();
+}
+
+void HostTrie::updateBest(int node)
+{
+    Node &current = nodes[node];
+    int best = current.references > 0 ? node : -1;
+    for (const auto &entry : std::as_const(current.children)) {
+        const int candidate = nodes.at(entry.second).best;
+        if (isBetter(candidate, best)) {
+            best = candidate;
+        }
+    }
+    current.best = best;
+}
+
+// Add a reference to host along with a weight.
+void HostTrie::add(const QString &host, double score)
+{
+    const QString key = host.toLower();
+    if (key.isEmpty()) {
+        return;
+    }
+    int node = 0;
+    for (const QChar c : key) {
+        int next = child(node, c.unicode());
+        if (next < 0) {
+            next = static_cast<int>(nodes.size());
+            Node created;
+            created.parent = node;
+            nodes.append(created);
+            nodes[node].children.append({c.unicode(), next});
+        }
+        node = next;
+    }
+    Node &leaf = nodes[node];
+    if (leaf.references++ == 0) {
+        leaf.host = key;
+        leaf.score = score;
+    } else {
+        leaf.score = logAdd(leaf.score, score);
+    }
+    promote(node);
+}
+
+// Add weight to a host that is already referenced, e.g. for a new visit of a known page.
+void HostTrie::boost(const QString &host, double score)
+{
+    const int node = find(host.toLower());
+    if (node > 0 && nodes.at(node).references > 0) {
+        nodes[node].score = logAdd(nodes.at(node).score, score);
+        promote(node);
+    }
+}
+
+// The score is log(sum of exp(weights)); log(exp(a) + exp(b)) without leaving log space.
+double HostTrie::logAdd(double a, double b)
+{
+    const double high = std::max(a, b);
+    return high + std::log1p(std::exp(std::min(a, b) - high));
+}
+
+// Only this host's score went up, so it either becomes or stays the best of every ancestor.
+void HostTrie::promote(int node)
+{
+    for (int ancestor = node; ancestor >= 0; ancestor = nodes.at(ancestor).parent) {
+        if (nodes.at(ancestor).best == node || isBetter(node, nodes.at(ancestor).best)) {
+            nodes[ancestor].best = node;
+        } else {
+            break;
+        }
+    }
+}
+
+// Drop a reference and the weight it added.
+void HostTrie::remove(const QString &host, double score)
+{
+    const int node = find(host.toLower());
+    if (node <= 0 || nodes.at(node).references == 0) {
+        return;
+    }
+    Node &leaf = nodes[node];
+    if (--leaf.references > 0) {
+        const double remaining = -std::expm1(score - leaf.score);
+        if (remaining > 0) {
+            leaf.score += std::log(remaining);
+        }
+    }
+    for (int ancestor = node; ancestor >= 0; ancestor = nodes.at(ancestor).parent) {
+        updateBest(ancestor);
+    }
+}
+
+// The best host starting with prefix, or an empty string.
+QString HostTrie::complete(const QString &prefix) const
+{
+    const int node = find(prefix.toLower());
+    if (node < 0 || nodes.at(node).best < 0) {
+        return {};
+    }
+    return nodes.at(nodes.at(node).best).host;
+}
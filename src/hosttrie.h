@@ -0,0 +1,67 @@
+/*****************************************************************************
+ * hosttrie.h
+ *****************************************************************************
+ * Copyright (C) 2026 MX Authors
+ *
+ * Authors: Adrian <adrian@mxlinux.org>
+ *          MX Linux <http://mxlinux.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MX Viewer is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MX Viewer.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#pragma once
+
+#include <QList>
+#include <QString>
+
+#include <utility>
+
+// Prefix tree of visited hosts ranked by frecency. Every visit adds a weight
+// that grows exponentially with the time of the visit, so recent visits count
+// more and old ones fade relative to them without ever rescoring. Scores are
+// kept as logarithms to stay finite: a weight is passed as its log, so adding
+// n visits at time t is add(host, t + log(n)). A host stays in the trie while
+// it has references. Every node remembers the best host below it, so
+// completing a prefix only walks the prefix.
+class HostTrie
+{
+public:
+    HostTrie();
+
+    void add(const QString &host, double score);
+    void boost(const QString &host, double score);
+    void remove(const QString &host, double score);
+    void clear();
+
+    [[nodiscard]] QString complete(const QString &prefix) const;
+
+private:
+    struct Node {
+        int parent {-1};
+        QList<std::pair<char16_t, int>> children;
+        QString host;
+        int references {};
+        double score {};
+        int best {-1};
+    };
+
+    QList<Node> nodes;
+
+    [[nodiscard]] int child(int node, char16_t key) const;
+    [[nodiscard]] int find(const QString &key) const;
+    [[nodiscard]] bool isBetter(int candidate, int current) const;
+    void promote(int node);
+    void updateBest(int node);
+
+    static double logAdd(double a, double b);
+};
@@ -0,0 +1,146 @@
+/*****************************************************************************
+ * loadscheduler.cpp
+ *****************************************************************************
+ * Copyright (C) 2026 MX Authors
+ *
+ * Authors: Adrian <adrian@mxlinux.org>
+ *          MX Linux <http://mxlinux.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MX Viewer is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MX Viewer.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#include "loadscheduler.h"
+#include "settings.h"
+#include "webview.h"
+
+#include <QCoreApplication>
+#include <QLoggingCategory>
+#include <QTimer>
+
+Q_LOGGING_CATEGORY(lcLoads, "mx.viewer.loads", QtWarningMsg)
+
+LoadScheduler::LoadScheduler(QObject *parent)
+    : QObject(parent),
+      limit {qMax(1, Settings::instance()->backgroundLoadLimit())}
+{
+}
+
+LoadScheduler *LoadScheduler::instance()
+{
+    static auto *scheduler = new LoadScheduler(QCoreApplication::instance());
+    return scheduler;
+}
+
+// Local pages cost next to nothing and are not queued. With a history stream the view gets its back
+// and forward list and loads only the current page of it.
+void LoadScheduler::load(WebView *view, const QUrl &url, bool foreground, const QByteArray &history)
+{
+    if (!view) {
+        return;
+    }
+    dequeue(view);
+    if (foreground || url.isLocalFile() || url.scheme() == "about") {
+        navigate(view, url, history);
+        return;
+    }
+    if (running.size() < limit) {
+        start(view, url, history, 0);
+        return;
+    }
+    Pending pending {view, url, history, {}};
+    pending.queued.start();
+    queue.append(pending);
+    qCDebug(lcLoads) << "queued" << url.toString() << "depth" << queue.size();
+}
+
+// The tab became visible: load it now, outside the background slots.
+void LoadScheduler::promote(WebView *view)
+{
+    Pending pending;
+    if (!dequeue(view, &pending)) {
+        return;
+    }
+    lastWait = pending.queued.elapsed();
+    maxWait = qMax(maxWait, lastWait);
+    qCDebug(lcLoads) << "promoted" << pending.url.toString() << "after" << lastWait << "ms, depth" << queue.size();
+    navigate(view, pending.url, pending.history);
+}
+
+LoadScheduler::Stats LoadScheduler::stats() const
+{
+    return {static_cast<int>(queue.size()), static_cast<int>(running.size()), limit, lastWait, maxWait};
+}
+
+void LoadScheduler::start(WebView *view, const QUrl &url, const QByteArray &history, qint64 waited)
+{
+    Running load {++nextToken, {}, {}, new QTimer(this)};
+    const quint64 token = load.token;
+    load.finished = connect(view, &WebView::loadFinished, this, [this, token] { release(token); });
+    load.destroyed = connect(view, &QObject::destroyed, this, [this, token] { release(token); });
+    load.timeout->setSingleShot(true);
+    connect(load.timeout, &QTimer::timeout, this, [this, token] { release(token); });
+    load.timeout->start(slotTimeout);
+    running.append(load);
+    lastWait = waited;
+    maxWait = qMax(maxWait, waited);
+    qCDebug(lcLoads) << "started" << url.toString() << "after" << waited << "ms, running" << running.size() << "depth"
+                     << queue.size();
+    navigate(view, url, history);
+}
+
+// Called for every way a load can end; the first call frees the slot and drops the others.
+void LoadScheduler::release(quint64 token)
+{
+    for (qsizetype i = 0; i < running.size(); ++i) {
+        if (running.at(i).token == token) {
+            const Running load = running.takeAt(i);
+            disconnect(load.finished);
+            disconnect(load.destroyed);
+            load.timeout->stop();
+            load.timeout->deleteLater();
+            startQueued();
+            return;
+        }
+    }
+}
+
+void LoadScheduler::startQueued()
+{
+    while (running.size() < limit && !queue.isEmpty()) {
+        const Pending pending = queue.takeFirst();
+        if (pending.view) {
+            start(pending.view, pending.url, pending.history, pending.queued.elapsed());
+        }
+    }
+}
+
+bool LoadScheduler::dequeue(const WebView *view, Pending *pending)
+{
+    for (qsizetype i = 0; i < queue.size(); ++i) {
+        if (queue.at(i).view == view) {
+            const Pending taken = queue.takeAt(i);
+            if (pending) {
+                *pending = taken;
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+void LoadScheduler::navigate(WebView *view, const QUrl &url, const QByteArray &history)
+{
+    if (!view->restoreHistory(history)) {
+        view->setUrl(url);
+    }
+}
@@ -0,0 +1,91 @@
+/*****************************************************************************
+ * loadscheduler.h
+ *****************************************************************************
+ * Copyright (C) 2026 MX Authors
+ *
+ * Authors: Adrian <adrian@mxlinux.org>
+ *          MX Linux <http://mxlinux.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MX Viewer is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MX Viewer.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#pragma once
+
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QList>
+#include <QObject>
+#include <QPointer>
+#include <QUrl>
+
+class QTimer;
+class WebView;
+
+// Starts the page loads of background tabs a few at a time, so opening many
+// links at once does not starve the visible tab. Loads of the current tab
+// are never queued, and a queued tab that is brought to the front starts at
+// once. Restored tabs wait the same way, with their saved back and forward
+// list. A load holds its slot until it finishes or for slotTimeout at most.
+// Queue depth and wait times are logged to the mx.viewer.loads category.
+class LoadScheduler : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Stats {
+        int queued {};
+        int running {};
+        int limit {};
+        qint64 lastWait {};
+        qint64 maxWait {};
+    };
+
+    static LoadScheduler *instance();
+
+    void load(WebView *view, const QUrl &url, bool foreground, const QByteArray &history = {});
+    void promote(WebView *view);
+    [[nodiscard]] Stats stats() const;
+
+private:
+    explicit LoadScheduler(QObject *parent = nullptr);
+
+    struct Pending {
+        QPointer<WebView> view;
+        QUrl url;
+        QByteArray history;
+        QElapsedTimer queued;
+    };
+
+    // A started load; the token tells it apart from later loads of the same view.
+    struct Running {
+        quint64 token {};
+        QMetaObject::Connection finished;
+        QMetaObject::Connection destroyed;
+        QTimer *timeout {};
+    };
+
+    QList<Pending> queue;
+    QList<Running> running;
+    quint64 nextToken {};
+    int limit {};
+    qint64 lastWait {};
+    qint64 maxWait {};
+
+    static constexpr int slotTimeout {15000};
+
+    void start(WebView *view, const QUrl &url, const QByteArray &history, qint64 waited);
+    void release(quint64 token);
+    void startQueued();
+    bool dequeue(const WebView *view, Pending *pending = nullptr);
+    static void navigate(WebView *view, const QUrl &url, const QByteArray &history);
+};
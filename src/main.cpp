@@ -20,7 +20,12 @@
  * along with MX Viewer.  If not, see <http://www.gnu.org/licenses/>.
  ****************************************************************************/
 
+#include "historyschemehandler.h"
 #include "mainwindow.h"
+#include "settings.h"
+#include "singleinstance.h"
+#include "startuptrace.h"
+#include "tasksschemehandler.h"
 
 #include <QApplication>
 #include <QCommandLineParser>
@@ -34,6 +39,8 @@
 #include <QTranslator>
 #include <unistd.h>
 
+#include <memory>
+
 #ifndef VERSION
     #define VERSION "?.?.?.?"
 #endif
@@ -76,6 +83,7 @@ bool dropElevatedPrivileges(bool force_nobody)
 
     // ref:
     // https://www.safaribooksonline.com/library/view/secure-programming-cookbook/0596003943/ch01s03.html#secureprgckbk-CHP-1-SECT-3.3
+    StartupTrace::Scope trace("getUserIDs");
     auto [id, gid] = getUserIDs();
     constexpr int nobody = 65534; // nobody (uid 65534), nogroup (gid 65534)
     if (id == 0 || gid == 0 || force_nobody) {
@@ -106,23 +114,8 @@ bool dropElevatedPrivileges(bool force_nobody)
     return true;
 }
 
-int main(int argc, char *argv[])
+void setupParser(QCommandLineParser &parser)
 {
-    QApplication::setHighDpiScaleFactorRoundingPolicy(Qt::HighDpiScaleFactorRoundingPolicy::PassThrough);
-    QGuiApplication::setQuitOnLastWindowClosed(true);
-    // Set Qt platform to XCB (X11) if not already set and we're in X11 environment
-    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
-        if (!qEnvironmentVariableIsEmpty("DISPLAY") && qEnvironmentVariableIsEmpty("WAYLAND_DISPLAY")) {
-            qputenv("QT_QPA_PLATFORM", "xcb");
-        }
-    }
-
-    QApplication app(argc, argv);
-    QApplication::setWindowIcon(QIcon::fromTheme(QApplication::applicationName()));
-    QApplication::setApplicationVersion(VERSION);
-    QApplication::setOrganizationName("MX-Linux");
-
-    QCommandLineParser parser;
     parser.setApplicationDescription(
         QObject::tr("This tool will display the URL content in a window, window title is optional"));
     parser.addHelpOption();
@@ -138,19 +131,92 @@ int main(int argc, char *argv[])
                          "would not be able to write its cache and cookies to the user directory, so it might break "
                          "some functionality.")});
     }
+    parser.addOption(
+        {"new-instance", QObject::tr("Start a new instance even if one is running in single-instance mode")});
     parser.addOption({{"s", "enable-spatial-navigation"}, QObject::tr("Enable spatial navigation with keyboard")});
     parser.addPositionalArgument(QObject::tr("URL"),
                                  QObject::tr("URL of the page you want to load")
                                      + "\ne.g., https://google.com, google.com, file:///home/user/file.html");
     parser.addPositionalArgument(QObject::tr("Title"), QObject::tr("Window title for the viewer"), "[title]");
+}
+
+// Open what a later invocation passed on: a new tab in the active window, or a window of its own
+// when it asks for a window title or different window or page settings.
+void openForwarded(const QStringList &arguments)
+{
+    auto parser = std::make_shared<QCommandLineParser>();
+    setupParser(*parser);
+    if (!parser->parse(arguments)) {
+        qWarning() << "Ignoring request from another instance:" << parser->errorText();
+        return;
+    }
+    MainWindow *window {};
+    const bool ownWindow = parser->positionalArguments().size() > 1 || parser->isSet("full-screen")
+                           || parser->isSet("disable-images") || parser->isSet("disable-js")
+                           || parser->isSet("enable-spatial-navigation");
+    if (!ownWindow) {
+        window = qobject_cast<MainWindow *>(QApplication::activeWindow());
+        const QWidgetList widgets = QApplication::topLevelWidgets();
+        for (auto it = widgets.cbegin(); !window && it != widgets.cend(); ++it) {
+            if ((*it)->isVisible()) {
+                window = qobject_cast<MainWindow *>(*it);
+            }
+        }
+    }
+    if (window) {
+        const QStringList positional = parser->positionalArguments();
+        window->openUrl(positional.isEmpty() ? QString() : positional.constFirst());
+    } else {
+        window = new MainWindow(*parser);
+        // The window refers to the parser, which lives as long as this connection.
+        QObject::connect(window, &QObject::destroyed, [parser] {});
+        window->show();
+    }
+    window->raise();
+    window->activateWindow();
+}
+
+int main(int argc, char *argv[])
+{
+    HistorySchemeHandler::registerScheme();
+    TasksSchemeHandler::registerScheme();
+    QApplication::setHighDpiScaleFactorRoundingPolicy(Qt::HighDpiScaleFactorRoundingPolicy::PassThrough);
+    QGuiApplication::setQuitOnLastWindowClosed(true);
+    // Set Qt platform to XCB (X11) if not already set and we're in X11 environment
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+        if (!qEnvironmentVariableIsEmpty("DISPLAY") && qEnvironmentVariableIsEmpty("WAYLAND_DISPLAY")) {
+            qputenv("QT_QPA_PLATFORM", "xcb");
+        }
+    }
+
+    StartupTrace::begin("QApplication");
+    QApplication app(argc, argv);
+    StartupTrace::end("QApplication");
+    QApplication::setWindowIcon(QIcon::fromTheme(QApplication::applicationName()));
+    QApplication::setApplicationVersion(VERSION);
+    QApplication::setOrganizationName("MX-Linux");
+
+    QCommandLineParser parser;
+    setupParser(parser);
     parser.process(app);
 
-    bool force_nobody = (getuid() == 0 || geteuid() == 0) ? parser.isSet("force-nobody") : false;
+    // Done before anything else is loaded, so handing over to a running instance is quick. Not when
+    // run as root: the request would be opened by an instance with other rights than asked for.
+    const bool elevated = getuid() == 0 || geteuid() == 0;
+    if (!elevated && !parser.isSet("new-instance")) {
+        StartupTrace::Scope trace("forward to running instance");
+        if (SingleInstance::forward(QApplication::arguments())) {
+            return EXIT_SUCCESS;
+        }
+    }
+
+    bool force_nobody = elevated ? parser.isSet("force-nobody") : false;
     if (!dropElevatedPrivileges(force_nobody)) {
         qDebug() << "Could not drop elevated privileges";
         exit(EXIT_FAILURE);
     }
 
+    StartupTrace::begin("translators");
     QTranslator qtTran;
     if (qtTran.load(QLocale::system(), "qt", "_", QLibraryInfo::path(QLibraryInfo::TranslationsPath))) {
         QApplication::installTranslator(&qtTran);
@@ -166,9 +232,23 @@ int main(int argc, char *argv[])
     if (appTran.load(QApplication::applicationName() + "_" + QLocale::system().name(), localePath)) {
         QApplication::installTranslator(&appTran);
     }
+    StartupTrace::end("translators");
 
+    StartupTrace::begin("MainWindow");
     auto *window = new MainWindow(parser);
+    StartupTrace::end("MainWindow");
+    StartupTrace::begin("show");
     window->show();
+    StartupTrace::end("show");
+
+    auto *single = SingleInstance::instance();
+    QObject::connect(single, &SingleInstance::openRequested, &app, &openForwarded);
+    auto *settings = Settings::instance();
+    // An instance started as root runs with dropped rights, so it does not take requests either.
+    if (!elevated) {
+        single->setEnabled(settings->singleInstance());
+        QObject::connect(settings, &Settings::singleInstanceChanged, single, &SingleInstance::setEnabled);
+    }
 
     // Ensure proper cleanup on application exit
     QObject::connect(&app, &QApplication::aboutToQuit, [window]() {
@@ -20,6 +20,15 @@
  * along with MX Viewer.  If not, see <http://www.gnu.org/licenses/>.
  ****************************************************************************/
 #include "mainwindow.h"
+#include "closedtabs.h"
+#include "faviconstore.h"
+#include "historycompletionmodel.h"
+#include "historystore.h"
+#include "loadscheduler.h"
+#include "profileregistry.h"
+#include "sessionjournal.h"
+#include "viewpool.h"
+#include "startuptrace.h"
 
 #include <QAbstractItemView>
 #include <QCheckBox>
@@ -34,20 +43,23 @@
 #include <QFormLayout>
 #include <QHBoxLayout>
 #include <QLineEdit>
-#include <QSet>
 #include <QSpinBox>
 #include <QtGlobal>
 #include <QListWidget>
 #include <QPushButton>
+#include <QSet>
 #include <QTimer>
 #include <QUrlQuery>
 #include <QVBoxLayout>
 #include <QWebEngineCookieStore>
 #include <QWebEngineProfile>
 #include <QWebEngineScript>
+#include <QWebEngineScriptCollection>
 #include <QWebEngineView>
 #include <QStandardPaths>
 
+#include <algorithm>
+
 namespace {
 qint64 directorySize(const QString &path)
 {
@@ -110,11 +122,10 @@ bool removeCachePath(const QString &path)
 
 MainWindow::MainWindow(const QCommandLineParser &argParser, QWidget *parent)
     : QMainWindow(parent),
-      downloadWidget {new DownloadWidget},
       searchBox {new QLineEdit(this)},
       progressBar {new QProgressBar(this)},
       toolBar {new QToolBar(this)},
-      webProfile {new QWebEngineProfile("mx-viewer", this)},
+      webProfile {ProfileRegistry::acquire()},
       tabWidget {new TabWidget(webProfile, this)},
       args {&argParser}
 {
@@ -138,11 +149,10 @@ MainWindow::MainWindow(const QCommandLineParser &argParser, QWidget *parent)
 
 MainWindow::MainWindow(const QUrl &url, QWidget *parent)
     : QMainWindow(parent),
-      downloadWidget {new DownloadWidget},
       searchBox {new QLineEdit(this)},
       progressBar {new QProgressBar(this)},
       toolBar {new QToolBar(this)},
-      webProfile {new QWebEngineProfile("mx-viewer", this)},
+      webProfile {ProfileRegistry::acquire()},
       tabWidget {new TabWidget(webProfile, this)},
       args {nullptr}
 {
@@ -158,34 +168,40 @@ void MainWindow::init()
     toolBar->toggleViewAction()->setVisible(false);
     connect(tabWidget, &TabWidget::currentChanged, this, [this] { tabChanged(); });
     connect(tabWidget, &TabWidget::newTabButtonClicked, this, [this] { addNewTab(); });
-    connect(tabWidget, &TabWidget::tabClosed, this, [this](const QUrl &url) {
-        if (url.isValid()) {
-            QIcon icon;
-            if (auto *view = currentWebView()) {
-                if (view->url() == url) {
-                    icon = view->icon();
-                }
-            }
-            if (icon.isNull()) {
-                for (int i = 0; i < tabWidget->count(); ++i) {
-                    if (auto *view = qobject_cast<WebView *>(tabWidget->widget(i))) {
-                        if (view->url() == url) {
-                            icon = view->icon();
-                            break;
-                        }
-                    }
-                }
-            }
-            closedTabs.append({url, icon});
-        }
-    });
-    websettings = webProfile->settings();
-    loadSettings();
-    addToolbar();
+    connect(tabWidget, &TabWidget::tabClosed, this, &MainWindow::rememberClosedTab);
+    connect(tabWidget, &TabWidget::viewAdded, this, &MainWindow::applyCommandLineSettings);
+    connect(tabWidget, &TabWidget::placeholderActivated, this,
+            [this](WebView *view, const TabPlaceholder *placeholder) {
+                loadSavedTab(view, placeholder->url, true, placeholder->history);
+            });
+    for (int i = 0; i < tabWidget->count(); ++i) {
+        applyCommandLineSettings(qobject_cast<WebView *>(tabWidget->widget(i)));
+    }
+    connect(webProfile, &QWebEngineProfile::downloadRequested, this, &MainWindow::downloadRequested);
+    {
+        StartupTrace::Scope trace("loadSettings");
+        loadSettings();
+    }
+    connectSettings();
+    {
+        StartupTrace::Scope trace("addToolbar");
+        addToolbar();
+    }
     addActions();
     setConnections();
 
-    restoredTabs = settings.value("SaveTabs", false).toBool() && restoreSavedTabs();
+    if (settings->saveTabs()) {
+        StartupTrace::Scope trace("restoreSavedTabs");
+        restoredTabs = restoreSavedTabs();
+        SessionJournal::instance()->attach(tabWidget);
+    }
+    connect(settings, &Settings::saveTabsChanged, this, [this](bool enabled) {
+        if (enabled) {
+            SessionJournal::instance()->attach(tabWidget);
+        } else {
+            SessionJournal::instance()->clear();
+        }
+    });
 
     auto *closeTabAction = new QAction(this);
     closeTabAction->setShortcut(QKeySequence::Close);
@@ -199,8 +215,12 @@ void MainWindow::init()
 
 MainWindow::~MainWindow()
 {
-    settings.setValue("Geometry", saveGeometry());
-    saveMenuItems(bookmarks, 2);
+    settings->setGeometry(saveGeometry());
+    if (bookmarksLoaded) {
+        saveMenuItems(bookmarks);
+    }
+    delete downloadWidget;
+    ProfileRegistry::release();
 }
 
 void MainWindow::addActions()
@@ -292,8 +312,15 @@ void MainWindow::addHistorySubmenu()
         QPoint globalPos = history->mapToGlobal(pos);
         QMenu submenu;
         submenu.addAction(QIcon::fromTheme("user-trash"), tr("Delete"), history, [this, pos] {
-            history->removeAction(history->actionAt(pos));
-            saveMenuItems(history, 3); // skip "clear history", separator, and first item added at menu refresh
+            QAction *action = history->actionAt(pos);
+            if (!action) {
+                return;
+            }
+            const QVariant closedTabId = action->property("closedTabId");
+            if (closedTabId.isValid()) {
+                ClosedTabs::instance()->remove(closedTabId.toULongLong());
+            }
+            history->removeAction(action);
         });
         submenu.exec(globalPos);
     });
@@ -301,13 +328,6 @@ void MainWindow::addHistorySubmenu()
 
 void MainWindow::addNewTab(const QUrl &url, bool makeCurrent)
 {
-    WebView *view = tabWidget->createTab(makeCurrent);
-    if (!view) {
-        return;
-    }
-    if (makeCurrent) {
-        setConnections();
-    }
     QUrl finalUrl = url;
     if (finalUrl.isEmpty() && openNewTabWithHome) {
         finalUrl = QUrl::fromUserInput(homeAddress);
@@ -315,8 +335,22 @@ void MainWindow::addNewTab(const QUrl &url, bool makeCurrent)
     if (finalUrl.isEmpty()) {
         finalUrl = QUrl("about:blank");
     }
-    view->setUrl(finalUrl);
+    WebView *view = tabWidget->createTab(makeCurrent, finalUrl);
+    if (!view) {
+        return;
+    }
+    if (makeCurrent) {
+        setConnections();
+    }
+    // A preloaded page was loaded without the command line settings of this window.
+    if (view->url().isEmpty() || hasCommandLineSettings()) {
+        LoadScheduler::instance()->load(view, finalUrl, makeCurrent);
+    }
     view->show();
+    const QIcon hostIcon = FaviconStore::instance()->iconForHost(finalUrl.host());
+    if (!hostIcon.isNull()) {
+        tabWidget->setTabIcon(tabWidget->indexOf(view), hostIcon);
+    }
     if (makeCurrent) {
         QTimer::singleShot(0, this, &MainWindow::focusAddressBarIfBlank);
         QMetaObject::Connection once;
@@ -346,149 +380,23 @@ void MainWindow::listHistory()
     recentLabel->setStyleSheet("color: #4a4a4a; padding: 4px 18px 4px 18px;");
     recentTitle->setDefaultWidget(recentLabel);
     history->addAction(recentTitle);
-    if (closedTabs.isEmpty()) {
+    auto *closedTabs = ClosedTabs::instance();
+    if (closedTabs->isEmpty()) {
         auto *emptyAction = history->addAction(tr("No recent tabs"));
         emptyAction->setEnabled(false);
     } else {
-        for (int i = closedTabs.size() - 1; i >= 0; --i) {
-            const int tabIndex = i;
-            const auto entry = closedTabs.at(i);
-            const QUrl url = entry.first;
-            auto *action = history->addAction(entry.second, url.toDisplayString());
-            connect(action, &QAction::triggered, this, [this, tabIndex] {
-                if (tabIndex < 0 || tabIndex >= closedTabs.size()) {
-                    return;
+        auto *favicons = FaviconStore::instance();
+        for (const ClosedTabs::Entry &entry : closedTabs->entries()) {
+            auto *action = history->addAction(favicons->icon(entry.iconRef), entry.url.toDisplayString());
+            action->setProperty("closedTabId", entry.id);
+            connect(action, &QAction::triggered, this, [this, closedTabs, id = entry.id] {
+                ClosedTabs::Entry closed;
+                if (closedTabs->take(id, &closed)) {
+                    reopenTab(closed);
                 }
-                const auto entry = closedTabs.takeAt(tabIndex);
-                openSavedTab(entry.first, true);
             });
         }
     }
-    refreshHistoryCompleter();
-}
-
-QString MainWindow::buildHistoryPageHtml()
-{
-    struct HistoryEntry {
-        QString title;
-        QString url;
-        QByteArray icon;
-    };
-
-    QList<HistoryEntry> entries;
-    int size = settings.beginReadArray("History");
-    entries.reserve(size);
-    for (int i = 0; i < size; ++i) {
-        settings.setArrayIndex(i);
-        const QString url = settings.value("url").toString();
-        if (url.isEmpty()) {
-            continue;
-        }
-        QString title = settings.value("title").toString();
-        if (title.isEmpty()) {
-            title = url;
-        }
-        entries.append({title, url, settings.value("icon").toByteArray()});
-    }
-    settings.endArray();
-
-    QStringList rows;
-    rows.reserve(entries.size());
-    for (int i = 0; i < entries.size(); ++i) {
-        const HistoryEntry &entry = entries.at(i);
-        const QString titleEscaped = entry.title.toHtmlEscaped();
-        const QString urlEscaped = entry.url.toHtmlEscaped();
-        const QString searchText = (entry.title + " " + entry.url).toLower().toHtmlEscaped();
-        QString iconHtml;
-        if (!entry.icon.isEmpty()) {
-            const QString iconBase64 = QString::fromLatin1(entry.icon.toBase64());
-            iconHtml = QStringLiteral("<img class=\"icon\" alt=\"\" src=\"data:image/png;base64,%1\">")
-                           .arg(iconBase64);
-        } else {
-            iconHtml = QStringLiteral("<span class=\"icon placeholder\"></span>");
-        }
-        rows.append(QStringLiteral(
-                        "<li class=\"entry\" data-search=\"%1\">"
-                        "%2"
-                        "<div class=\"content\">"
-                        "<div class=\"row\">"
-                        "<a class=\"title\" href=\"%3\">%4</a>"
-                        "<button class=\"delete\" data-index=\"%5\">%6</button>"
-                        "</div>"
-                        "<div class=\"url\">%7</div>"
-                        "</div>"
-                        "</li>")
-                        .arg(searchText, iconHtml, urlEscaped, titleEscaped, QString::number(i),
-                             tr("Delete").toHtmlEscaped(), urlEscaped));
-    }
-
-    const QString emptyText = tr("No history entries.");
-    const QString html = QStringLiteral(R"(<!doctype html>
-<html>
-<head>
-  <meta charset="utf-8">
-  <meta http-equiv="cache-control" content="no-cache">
-  <title>%1</title>
-  <style>
-    :root { color-scheme: light; }
-    body { font-family: sans-serif; margin: 24px; color: #1f2328; background: #ffffff; }
-    h1 { font-size: 22px; margin: 0 0 12px; }
-    .controls { display: flex; gap: 12px; align-items: center; margin-bottom: 16px; flex-wrap: wrap; }
-    .search { flex: 1 1 240px; padding: 8px 10px; border: 1px solid #d0d7de; border-radius: 6px; }
-    .clear { padding: 8px 12px; border: 1px solid #d0d7de; background: #f6f8fa; border-radius: 6px; cursor: pointer; }
-    .list { list-style: none; padding: 0; margin: 0; display: flex; flex-direction: column; gap: 10px; }
-    .entry { display: grid; grid-template-columns: 24px 1fr; gap: 10px; padding: 10px 12px; border: 1px solid #eaeef2; border-radius: 8px; }
-    .icon { width: 20px; height: 20px; border-radius: 4px; }
-    .icon.placeholder { background: #eaeef2; }
-    .content { display: flex; flex-direction: column; gap: 4px; }
-    .row { display: flex; align-items: center; gap: 10px; }
-    .title { color: #0969da; text-decoration: none; font-weight: 600; flex: 1 1 auto; }
-    .url { color: #57606a; font-size: 12px; word-break: break-all; }
-    .delete { padding: 4px 8px; border: 1px solid #d0d7de; background: #fff; border-radius: 6px; cursor: pointer; }
-    .empty { padding: 16px; border: 1px dashed #d0d7de; border-radius: 8px; color: #57606a; }
-  </style>
-</head>
-<body>
-  <h1>%1</h1>
-  <div class="controls">
-    <input id="search" class="search" type="search" placeholder="%2" autofocus>
-    <button id="clear" class="clear">%3</button>
-  </div>
-  %4
-  <script>
-    const search = document.getElementById('search');
-    const entries = Array.from(document.querySelectorAll('li.entry'));
-    function applyFilter() {
-      const term = search.value.trim().toLowerCase();
-      entries.forEach(entry => {
-        entry.style.display = entry.dataset.search.includes(term) ? '' : 'none';
-      });
-    }
-    search.addEventListener('input', applyFilter);
-    document.querySelectorAll('button.delete').forEach(btn => {
-      btn.addEventListener('click', event => {
-        event.preventDefault();
-        location.href = 'mx-history://delete?index=' + btn.dataset.index;
-      });
-    });
-    const clearButton = document.getElementById('clear');
-    clearButton.addEventListener('click', event => {
-      event.preventDefault();
-      if (confirm('%5')) {
-        location.href = 'mx-history://clear';
-      }
-    });
-  </script>
-</body>
-</html>)")
-                            .arg(tr("History").toHtmlEscaped(), tr("Search history").toHtmlEscaped(),
-                                 tr("Clear history").toHtmlEscaped(),
-                                 rows.isEmpty()
-                                     ? QStringLiteral("<div class=\"empty\">%1</div>").arg(emptyText.toHtmlEscaped())
-                                     : QStringLiteral("<ul class=\"list\">%1</ul>").arg(rows.join("\n")),
-                                 tr("Clear all history entries?").toHtmlEscaped());
-
-    return html;
 }
 
 void MainWindow::renderHistoryPage(WebView *view)
@@ -496,7 +404,7 @@ void MainWindow::renderHistoryPage(WebView *view)
     if (!view) {
         return;
     }
-    view->setHtml(buildHistoryPageHtml(), QUrl("mx-history://list"));
+    view->setUrl(QUrl("mx-history://list"));
     view->show();
     tabWidget->setTabText(tabWidget->indexOf(view), tr("History"));
     setWindowTitle(tr("History"));
@@ -519,110 +427,6 @@ void MainWindow::openHistoryPage()
     renderHistoryPage(view);
 }
 
-void MainWindow::removeHistoryEntry(int index)
-{
-    if (index < 0) {
-        return;
-    }
-    struct HistoryEntry {
-        QString title;
-        QString url;
-        QByteArray icon;
-    };
-    QList<HistoryEntry> entries;
-    int size = settings.beginReadArray("History");
-    entries.reserve(size);
-    for (int i = 0; i < size; ++i) {
-        settings.setArrayIndex(i);
-        const QString url = settings.value("url").toString();
-        if (url.isEmpty()) {
-            continue;
-        }
-        entries.append({settings.value("title").toString(), url, settings.value("icon").toByteArray()});
-    }
-    settings.endArray();
-    if (index >= entries.size()) {
-        return;
-    }
-    entries.removeAt(index);
-    settings.beginWriteArray("History");
-    for (int i = 0; i < entries.size(); ++i) {
-        settings.setArrayIndex(i);
-        settings.setValue("title", entries.at(i).title);
-        settings.setValue("url", entries.at(i).url);
-        if (!entries.at(i).icon.isEmpty()) {
-            settings.setValue("icon", entries.at(i).icon);
-        }
-    }
-    settings.endArray();
-    settings.setValue("History/size", entries.size());
-}
-
-void MainWindow::clearHistoryEntries()
-{
-    settings.remove("History");
-    settings.setValue("History/size", 0);
-}
-
-bool MainWindow::handleHistoryRequest(const QUrl &url)
-{
-    if (url.scheme() != "mx-history") {
-        return false;
-    }
-    const QString action = url.host();
-    if (action == "delete") {
-        QUrlQuery query(url);
-        removeHistoryEntry(query.queryItemValue("index").toInt());
-    } else if (action == "clear") {
-        clearHistoryEntries();
-    } else {
-        return false;
-    }
-    refreshHistoryCompleter();
-    renderHistoryPage(currentWebView());
-    return true;
-}
-
-void MainWindow::refreshHistoryCompleter()
-{
-    QStringList completions;
-    QStringList hosts;
-    QSet<QString> seenUrls;
-    QSet<QString> seenHosts;
-    int size = settings.beginReadArray("History");
-    completions.reserve(size);
-    for (int i = size - 1; i >= 0; --i) {
-        settings.setArrayIndex(i);
-        const QString urlValue = settings.value("url").toString();
-        if (urlValue.isEmpty() || urlValue == "about:blank") {
-            continue;
-        }
-        const QUrl url = QUrl::fromUserInput(urlValue);
-        if (url.scheme() == "mx-history" || url.scheme() == "mx-settings") {
-            continue;
-        }
-        const QString host = url.host();
-        if (!host.isEmpty() && !seenHosts.contains(host)) {
-            seenHosts.insert(host);
-            hosts.append(host);
-            if (host.startsWith("www.", Qt::CaseInsensitive)) {
-                const QString stripped = host.mid(4);
-                if (!seenHosts.contains(stripped)) {
-                    seenHosts.insert(stripped);
-                    hosts.append(stripped);
-                }
-            }
-        }
-        if (!seenUrls.contains(urlValue)) {
-            seenUrls.insert(urlValue);
-            completions.append(urlValue);
-        }
-    }
-    settings.endArray();
-    historyCompletionModel->setStringList(completions);
-    historyCompletionHosts = hosts;
-}
-
 void MainWindow::addToolbar()
 {
     addToolBar(toolBar);
@@ -633,7 +437,10 @@ void MainWindow::addToolbar()
     setupSearchBox();
     addZoomActions();
     setupMenuButton();
-    buildMenu();
+    {
+        StartupTrace::Scope trace("buildMenu");
+        buildMenu();
+    }
     toolBar->show();
 }
 
@@ -649,6 +456,9 @@ void MainWindow::addNavigationActions()
     reloadAction->setShortcutContext(Qt::ApplicationShortcut);
     toolBar->addAction(reloadAction);
     toolBar->addAction(stop);
+    backAction = back;
+    forwardAction = forward;
+    stopAction = stop;
     back->setShortcut(QKeySequence::Back);
     forward->setShortcut(QKeySequence::Forward);
     reloadAction->setShortcuts(QKeySequence::Refresh);
@@ -660,6 +470,7 @@ void MainWindow::addNavigationActions()
 void MainWindow::addHomeAction()
 {
     auto *home {new QAction(QIcon::fromTheme("go-home", QIcon(":/icons/go-home.svg")), tr("Home"))};
+    homeAction = home;
     toolBar->addAction(home);
     home->setShortcut(Qt::ALT | Qt::Key_Home);
     connect(home, &QAction::triggered, this, [this] { displaySite(); });
@@ -670,8 +481,7 @@ void MainWindow::setupAddressBar()
     addressBar = new AddressBar(this);
     addressBar->setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Fixed);
     addressBar->setClearButtonEnabled(true);
-    historyCompletionModel = new QStringListModel(this);
-    historyCompleter = new QCompleter(historyCompletionModel, this);
+    historyCompleter = new QCompleter(HistoryCompletionModel::instance(), this);
     historyCompleter->setCaseSensitivity(Qt::CaseInsensitive);
     historyCompleter->setCompletionMode(QCompleter::PopupCompletion);
     historyCompleter->setFilterMode(Qt::MatchContains);
@@ -683,7 +493,6 @@ void MainWindow::setupAddressBar()
             });
     connect(addressBar, &AddressBar::focused, this, [this] {
         lastAddressEditLength = addressBar->text().size();
-        refreshHistoryCompleter();
     });
     connect(addressBar, &AddressBar::keyPressed, this, [this](int key) {
         lastAddressEditWasDeletion = (key == Qt::Key_Backspace || key == Qt::Key_Delete);
@@ -706,11 +515,6 @@ void MainWindow::setupAddressBar()
             lastAddressEditWasDeletion = false;
             return;
         }
-        if (historyCompletionHosts.isEmpty()) {
-            lastAddressEditLength = text.size();
-            lastAddressEditWasDeletion = false;
-            return;
-        }
         QString prefix;
         QString hostInput = trimmed;
         const int schemeIndex = trimmed.indexOf("://");
@@ -724,13 +528,7 @@ void MainWindow::setupAddressBar()
             lastAddressEditWasDeletion = false;
             return;
         }
-        QString match;
-        for (const QString &entry : historyCompletionHosts) {
-            if (entry.startsWith(hostInput, Qt::CaseInsensitive)) {
-                match = entry;
-                break;
-            }
-        }
+        const QString match = HistoryCompletionModel::instance()->completeHost(hostInput);
         if (match.isEmpty() || match.compare(hostInput, Qt::CaseInsensitive) == 0) {
             lastAddressEditLength = text.size();
             lastAddressEditWasDeletion = false;
@@ -743,7 +541,6 @@ void MainWindow::setupAddressBar()
         completingHistory = false;
         lastAddressEditWasDeletion = false;
     });
-    refreshHistoryCompleter();
     addBookmark = addressBar->addAction(QIcon::fromTheme("emblem-favorite", QIcon(":/icons/emblem-favorite.png")),
                                         QLineEdit::TrailingPosition);
     addBookmark->setToolTip(tr("Add bookmark"));
@@ -827,66 +624,43 @@ void MainWindow::displaySite(QString url, const QString &title)
     setWindowTitle(title);
 }
 
+// Bookmarks are read on first use (menu shown, bookmark added, editor opened) to keep them off the startup path.
 void MainWindow::loadBookmarks()
 {
-    int size = settings.beginReadArray("Bookmarks");
+    if (bookmarksLoaded) {
+        return;
+    }
+    bookmarksLoaded = true;
+    StartupTrace::Scope trace("loadBookmarks");
+    auto *favicons = FaviconStore::instance();
+    QSettings *store = settings->store();
+    int size = store->beginReadArray("Bookmarks");
     for (int i = 0; i < size; ++i) {
-        settings.setArrayIndex(i);
+        store->setArrayIndex(i);
+        // Older versions stored a serialized QIcon, it is replaced by a reference on the next save
+        const QIcon icon = store->contains("iconRef") ? favicons->icon(store->value("iconRef").toByteArray())
+                                                      : store->value("icon").value<QIcon>();
         QAction *bookmark {nullptr};
-        bookmarks->addAction(bookmark
-                             = new QAction(settings.value("icon").value<QIcon>(), settings.value("title").toString()));
-        bookmark->setProperty("url", settings.value("url"));
+        bookmarks->addAction(bookmark = new QAction(icon, store->value("title").toString()));
+        bookmark->setProperty("url", store->value("url"));
         connectAddress(bookmark, bookmarks);
     }
-    settings.endArray();
-}
-
-void MainWindow::loadHistory()
-{
-    int size = settings.beginReadArray("History");
-    for (int i = 0; i < size; ++i) {
-        settings.setArrayIndex(i);
-        QAction *histItem {nullptr};
-        QIcon restoredIcon;
-        QByteArray iconByteArray = settings.value("icon").toByteArray();
-        if (!iconByteArray.isEmpty()) {
-            QPixmap restoredIconPixmap;
-            if (restoredIconPixmap.loadFromData(iconByteArray)) {
-                restoredIcon.addPixmap(restoredIconPixmap);
-            }
-        }
-        history->addAction(histItem = new QAction(restoredIcon, settings.value("title").toString()));
-        histItem->setProperty("url", settings.value("url"));
-        connectAddress(histItem, history);
-    }
-    settings.endArray();
+    store->endArray();
 }
 
 void MainWindow::loadSettings()
 {
-    // Load first from system .conf file and then overwrite with CLI switches where available
-    websettings->setAttribute(QWebEngineSettings::FullScreenSupportEnabled, true);
-    websettings->setAttribute(QWebEngineSettings::DnsPrefetchEnabled, true);
-    webProfile->setHttpAcceptLanguage(QLocale::system().name());
-
-    homeAddress = settings.value("Home", "https://start.duckduckgo.com").toString();
-    showProgress = settings.value("ShowProgressBar", false).toBool();
-    openNewTabWithHome = settings.value("OpenNewTabWithHome", true).toBool();
-    zoomPercent = settings.value("ZoomPercent", 100).toInt();
-    cookiesEnabled = settings.value("EnableCookies", true).toBool();
-    clearCookiesAtExit = settings.value("ClearCookiesAtExit", false).toBool();
-    searchEngine = settings.value("SearchEngine", "DuckDuckGo").toString();
-    searchEngineCustom = settings.value("SearchEngineCustom", QString()).toString();
-    if (!settings.contains("EnableJavaScript") && settings.contains("DisableJava")) {
-        settings.setValue("EnableJavaScript", !settings.value("DisableJava", false).toBool());
-    }
+    readSettings();
+    zoomPercent = settings->zoomPercent();
+    cookiesEnabled = settings->enableCookies();
 
     applyWebSettings();
+    applyHistoryRetention();
 
     QSize size {defaultWidth, defaultHeight};
-    const bool canRestore = settings.contains("Geometry") && (!args || !args->isSet("full-screen"));
+    const bool canRestore = !settings->geometry().isEmpty() && (!args || !args->isSet("full-screen"));
     if (canRestore) {
-        const bool restored = restoreGeometry(settings.value("Geometry").toByteArray());
+        const bool restored = restoreGeometry(settings->geometry());
         if (!restored) {
             resize(size);
             centerWindow();
@@ -897,6 +671,52 @@ void MainWindow::loadSettings()
     }
 }
 
+void MainWindow::readSettings()
+{
+    homeAddress = settings->home();
+    showProgress = settings->showProgressBar();
+    openNewTabWithHome = settings->openNewTabWithHome();
+    ViewPool::instance()->setPreloadUrl(openNewTabWithHome ? QUrl::fromUserInput(homeAddress) : QUrl());
+    searchEngine = settings->searchEngine();
+    searchEngineCustom = settings->searchEngineCustom();
+}
+
+// Settings saved from any window take effect in this one too. The web settings are applied once
+// for all the changes of a save.
+void MainWindow::connectSettings()
+{
+    connect(settings, &Settings::homeChanged, this, &MainWindow::readSettings);
+    connect(settings, &Settings::searchEngineChanged, this, &MainWindow::readSettings);
+    connect(settings, &Settings::searchEngineCustomChanged, this, &MainWindow::readSettings);
+    connect(settings, &Settings::openNewTabWithHomeChanged, this, &MainWindow::readSettings);
+    connect(settings, &Settings::showProgressBarChanged, this, &MainWindow::readSettings);
+    connect(settings, &Settings::zoomPercentChanged, this, [this](int percent) { setZoomPercent(percent, false); });
+
+    webSettingsTimer.setSingleShot(true);
+    webSettingsTimer.setInterval(0);
+    connect(&webSettingsTimer, &QTimer::timeout, this, &MainWindow::applyWebSettings);
+    auto applyLater = [this] { webSettingsTimer.start(); };
+    connect(settings, &Settings::spatialNavigationChanged, this, applyLater);
+    connect(settings, &Settings::enableJavaScriptChanged, this, applyLater);
+    connect(settings, &Settings::loadImagesChanged, this, applyLater);
+    connect(settings, &Settings::enableCookiesChanged, this, applyLater);
+    connect(settings, &Settings::enableThirdPartyCookiesChanged, this, applyLater);
+    connect(settings, &Settings::allowPopupsChanged, this, applyLater);
+
+    connect(settings, &Settings::historyMaxEntriesChanged, this, &MainWindow::applyHistoryRetention);
+    connect(settings, &Settings::historyMaxAgeDaysChanged, this, &MainWindow::applyHistoryRetention);
+    connect(settings, &Settings::historyMaxSizeMBChanged, this, &MainWindow::applyHistoryRetention);
+}
+
+void MainWindow::applyHistoryRetention()
+{
+    HistoryStore::Retention retention;
+    retention.maxEntries = qMax(0, settings->historyMaxEntries());
+    retention.maxAgeDays = qMax(0, settings->historyMaxAgeDays());
+    retention.maxBytes = qMax(0, settings->historyMaxSizeMB()) * 1024LL * 1024;
+    HistoryStore::instance()->setRetention(retention);
+}
+
 void MainWindow::centerWindow()
 {
     QRect screenGeometry = QApplication::primaryScreen()->geometry();
@@ -1001,37 +821,27 @@ void MainWindow::openFromAddressBarText(const QString &inputText)
     displaySite(input);
 }
 
-void MainWindow::saveMenuItems(const QMenu *menu, int offset)
+void MainWindow::saveMenuItems(const QMenu *menu)
 {
-    // Offset is for skipping "Clear history" item, separator, etc.
-    settings.beginWriteArray(menu->objectName());
-    if (menu->objectName() == "Bookmarks") {
-        int index = 0;
-        for (auto *action : menu->actions()) {
-            if (!action->property("url").isValid()) {
-                continue;
-            }
-            settings.setArrayIndex(index++);
-            settings.setValue("title", action->text());
-            settings.setValue("url", action->property("url").toString());
-            settings.setValue("icon", action->icon());
+    auto *favicons = FaviconStore::instance();
+    QSettings *store = settings->store();
+    store->remove(menu->objectName());
+    store->beginWriteArray(menu->objectName());
+    int index = 0;
+    for (auto *action : menu->actions()) {
+        if (!action->property("url").isValid()) {
+            continue;
         }
-    } else {
-        for (int i = offset; i < menu->actions().count(); ++i) {
-            settings.setArrayIndex(i - offset);
-            settings.setValue("title", menu->actions().at(i)->text());
-            settings.setValue("url", menu->actions().at(i)->property("url").toString());
-
-            QPixmap iconPixmap = menu->actions().at(i)->icon().pixmap(QSize(16, 16));
-            QByteArray iconByteArray;
-            QBuffer buffer(&iconByteArray);
-            if (buffer.open(QIODevice::WriteOnly)) {
-                iconPixmap.save(&buffer, "PNG");
-                settings.setValue("icon", iconByteArray);
-            }
+        const QString url = action->property("url").toString();
+        store->setArrayIndex(index++);
+        store->setValue("title", action->text());
+        store->setValue("url", url);
+        const QByteArray iconRef = favicons->add(action->icon(), QUrl(url).host());
+        if (!iconRef.isEmpty()) {
+            store->setValue("iconRef", iconRef);
         }
     }
-    settings.endArray();
+    store->endArray();
 }
 
 void MainWindow::setConnections()
@@ -1039,8 +849,6 @@ void MainWindow::setConnections()
     if (!currentWebView()) {
         return;
     }
-    websettings = currentWebView()->settings();
-    applyWebSettings();
     if (loadStartedConn) {
         disconnect(loadStartedConn);
     }
@@ -1055,8 +863,6 @@ void MainWindow::setConnections()
         disconnect(urlChangedConn);
     }
     urlChangedConn = connect(currentWebView(), &QWebEngineView::urlChanged, this, &MainWindow::updateUrl);
-    connect(webProfile, &QWebEngineProfile::downloadRequested, downloadWidget,
-            &DownloadWidget::downloadRequested, Qt::UniqueConnection);
     if (loadFinishedConn) {
         disconnect(loadFinishedConn);
     }
@@ -1106,28 +912,17 @@ void MainWindow::showFullScreenNotification()
     });
 }
 
+// Only the previous and the new view are touched, whatever the number of tabs.
 void MainWindow::tabChanged()
 {
     if (!currentWebView()) {
         return;
     }
-    auto *back = pageAction(QWebEnginePage::Back);
-    auto *forward = pageAction(QWebEnginePage::Forward);
     auto *reload = pageAction(QWebEnginePage::Reload);
-    auto *stop = pageAction(QWebEnginePage::Stop);
-    QMap<QString, QAction *> actionMap = {{"Back", back}, {"Forward", forward}, {"Reload", reloadAction}, {"Stop", stop}};
-    auto actionList = toolBar->actions();
     toolBar->setUpdatesEnabled(false);
-    for (int i = 0; i < actionList.size() - 1; ++i) {
-        auto *currentAction = actionList.at(i);
-        auto *nextAction = actionList.at(i + 1);
-        auto it = actionMap.find(currentAction->text());
-        if (it != actionMap.end()) {
-            QAction *replacementAction = it.value();
-            toolBar->removeAction(currentAction);
-            toolBar->insertAction(nextAction, replacementAction);
-        }
-    }
+    showPageAction(&backAction, pageAction(QWebEnginePage::Back), reloadAction);
+    showPageAction(&forwardAction, pageAction(QWebEnginePage::Forward), reloadAction);
+    showPageAction(&stopAction, pageAction(QWebEnginePage::Stop), homeAction);
     toolBar->setUpdatesEnabled(true);
     if (reloadAction) {
         reloadAction->setIcon(reload->icon());
@@ -1146,6 +941,19 @@ void MainWindow::tabChanged()
     }
 }
 
+// Put the action in the toolbar where the previous page's one was, or before the given action if that page is gone.
+void MainWindow::showPageAction(QPointer<QAction> *shown, QAction *action, QAction *before)
+{
+    if (*shown == action) {
+        return;
+    }
+    toolBar->insertAction(*shown ? shown->data() : before, action);
+    if (*shown) {
+        toolBar->removeAction(*shown);
+    }
+    *shown = action;
+}
+
 // Show the hovered URL in the status bar and connect it to launch it.
 void MainWindow::connectAddress(const QAction *action, const QMenu *menu)
 {
@@ -1180,7 +988,7 @@ void MainWindow::buildMenu()
     addViewMenuActions(menu);
     addHelpMenuActions(menu);
 
-    loadBookmarks();
+    connect(bookmarks, &QMenu::aboutToShow, this, &MainWindow::loadBookmarks);
     addBookmarksSubmenu();
 
     setupMenuConnections(menu);
@@ -1200,6 +1008,7 @@ void MainWindow::addViewMenuActions(QMenu *menu)
     QAction *devTools {nullptr};
     QAction *historyAction {nullptr};
     QAction *downloadAction {nullptr};
+    QAction *tasksAction {nullptr};
     QAction *bookmarkAction {nullptr};
     QAction *manageBookmarks {nullptr};
     menu->addAction(fullScreen = new QAction(QIcon::fromTheme("view-fullscreen"), tr("&Full screen")));
@@ -1210,6 +1019,8 @@ void MainWindow::addViewMenuActions(QMenu *menu)
     historyAction->setMenu(history);
     menu->addAction(downloadAction = new QAction(QIcon::fromTheme("folder-download"), tr("&Downloads")));
     downloadAction->setShortcut(Qt::CTRL | Qt::Key_J);
+    menu->addAction(tasksAction = new QAction(QIcon::fromTheme("utilities-system-monitor"), tr("&Task manager")));
+    tasksAction->setShortcut(Qt::SHIFT | Qt::Key_Escape);
     menu->addAction(bookmarkAction = new QAction(QIcon::fromTheme("emblem-favorite"), tr("&Bookmarks")));
     bookmarkAction->setMenu(bookmarks);
     bookmarks->addAction(addBookmark);
@@ -1220,9 +1031,11 @@ void MainWindow::addViewMenuActions(QMenu *menu)
     bookmarks->addSeparator();
     connect(fullScreen, &QAction::triggered, this, &MainWindow::toggleFullScreen);
     connect(devTools, &QAction::triggered, this, &MainWindow::openDevTools);
-    connect(downloadAction, &QAction::triggered, downloadWidget, &QWidget::show);
+    connect(downloadAction, &QAction::triggered, this, [this] { downloads()->show(); });
+    connect(tasksAction, &QAction::triggered, this, [this] { addNewTab(QUrl("mx-tasks://list"), true); });
     connect(manageBookmarks, &QAction::triggered, this, &MainWindow::openBookmarksEditor);
     connect(addBookmark, &QAction::triggered, this, [this] {
+        loadBookmarks();
         QAction *bookmark {nullptr};
         bookmarks->addAction(bookmark = new QAction(currentWebView()->icon(), currentWebView()->title()));
         bookmark->setProperty("url", currentWebView()->url());
@@ -1307,14 +1120,21 @@ void MainWindow::openSettings()
 
 QString MainWindow::buildSettingsPageHtml()
 {
-    const bool spatialNav = settings.value("SpatialNavigation", false).toBool();
-    const bool enableJs = settings.value("EnableJavaScript", true).toBool();
-    const bool loadImages = settings.value("LoadImages", true).toBool();
-    const bool enableCookies = settings.value("EnableCookies", true).toBool();
-    const bool enableThirdPartyCookies = settings.value("EnableThirdPartyCookies", true).toBool();
-    const bool allowPopups = settings.value("AllowPopups", true).toBool();
-    const bool saveTabs = settings.value("SaveTabs", false).toBool();
-    const bool clearCookiesAtExit = settings.value("ClearCookiesAtExit", false).toBool();
+    const bool spatialNav = settings->spatialNavigation();
+    const bool enableJs = settings->enableJavaScript();
+    const bool loadImages = settings->loadImages();
+    const bool enableCookies = settings->enableCookies();
+    const bool enableThirdPartyCookies = settings->enableThirdPartyCookies();
+    const bool allowPopups = settings->allowPopups();
+    const bool saveTabs = settings->saveTabs();
+    const bool singleInstance = settings->singleInstance();
+    const int restoreLoadedTabs = settings->restoreLoadedTabs();
+    const bool clearCookiesAtExit = settings->clearCookiesAtExit();
+    const int historyMaxEntries = settings->historyMaxEntries();
+    const int historyMaxAgeDays = settings->historyMaxAgeDays();
+    const int historyMaxSizeMB = settings->historyMaxSizeMB();
+    const qint64 historyBytes = HistoryStore::instance()->diskUsage();
+    const QString historySizeText = historyBytes >= 0 ? DownloadWidget::withUnit(historyBytes) : tr("unknown");
 
     auto check = [](bool value) { return value ? QStringLiteral("checked") : QString(); };
     auto disabled = [](bool value) { return value ? QString() : QStringLiteral("disabled"); };
@@ -1392,10 +1212,28 @@ QString MainWindow::buildSettingsPageHtml()
     <label class="check"><input id="clearCookiesAtExit" name="clearCookiesAtExit" type="checkbox" value="1" %32> %33</label>
     <label class="check"><input id="allowPopups" name="allowPopups" type="checkbox" value="1" %34> %35</label>
     <label class="check"><input id="saveTabs" name="saveTabs" type="checkbox" value="1" %36> %37</label>
+    <div class="row">
+      <label for="restoreLoadedTabs">%55</label>
+      <input id="restoreLoadedTabs" name="restoreLoadedTabs" class="input" type="number" min="0" value="%56">
+    </div>
+    <label class="check"><input id="singleInstance" name="singleInstance" type="checkbox" value="1" %53> %54</label>
     <div class="check-row">
       <div class="cache-label">%42</div>
       <button class="btn btn-inline" id="clearCache" type="button">%43</button>
     </div>
+    <div class="row">
+      <label for="historyMaxEntries">%46</label>
+      <input id="historyMaxEntries" name="historyMaxEntries" class="input" type="number" min="0" value="%47">
+    </div>
+    <div class="row">
+      <label for="historyMaxAge">%48</label>
+      <input id="historyMaxAge" name="historyMaxAge" class="input" type="number" min="0" value="%49">
+    </div>
+    <div class="row">
+      <label for="historyMaxSize">%50</label>
+      <input id="historyMaxSize" name="historyMaxSize" class="input" type="number" min="0" value="%51">
+    </div>
+    <div class="cache-label">%52</div>
     <div class="actions">
       <button class="btn" id="save" type="submit">%38</button>
       <button class="btn" id="reset" type="reset">%39</button>
@@ -1471,7 +1309,12 @@ QString MainWindow::buildSettingsPageHtml()
       params.set('thirdPartyCookies', boolValue('thirdPartyCookies'));
       params.set('allowPopups', boolValue('allowPopups'));
       params.set('saveTabs', boolValue('saveTabs'));
+      params.set('restoreLoadedTabs', document.getElementById('restoreLoadedTabs').value);
+      params.set('singleInstance', boolValue('singleInstance'));
       params.set('clearCookiesAtExit', boolValue('clearCookiesAtExit'));
+      params.set('historyMaxEntries', document.getElementById('historyMaxEntries').value);
+      params.set('historyMaxAge', document.getElementById('historyMaxAge').value);
+      params.set('historyMaxSize', document.getElementById('historyMaxSize').value);
       baseline = snapshot();
       updateDirtyState();
       location.href = 'mx-settings://save?' + params.toString();
@@ -1561,7 +1404,18 @@ QString MainWindow::buildSettingsPageHtml()
                                  tr("Cache size: %1").arg(cacheSizeText).toHtmlEscaped(),
                                  tr("Clear cache").toHtmlEscaped(),
                                  tr("Clear all cookies?").toHtmlEscaped(),
-                                 tr("Clear the cache?").toHtmlEscaped());
+                                 tr("Clear the cache?").toHtmlEscaped(),
+                                 tr("Maximum history entries (0 for no limit)").toHtmlEscaped(),
+                                 QString::number(historyMaxEntries),
+                                 tr("Remove history older than, in days (0 to keep)").toHtmlEscaped(),
+                                 QString::number(historyMaxAgeDays),
+                                 tr("Maximum history size in MB (0 for no limit)").toHtmlEscaped(),
+                                 QString::number(historyMaxSizeMB),
+                                 tr("History size: %1").arg(historySizeText).toHtmlEscaped(),
+                                 check(singleInstance),
+                                 tr("Open pages from other programs in this window").toHtmlEscaped(),
+                                 tr("Saved tabs to load at startup besides the current one").toHtmlEscaped(),
+                                 QString::number(restoreLoadedTabs));
 
     return html;
 }
@@ -1652,69 +1506,74 @@ bool MainWindow::handleSettingsRequest(const QUrl &url)
     bool newThirdParty = query.queryItemValue("thirdPartyCookies") == "1";
     const bool newAllowPopups = query.queryItemValue("allowPopups") == "1";
     const bool newSaveTabs = query.queryItemValue("saveTabs") == "1";
+    const bool newSingleInstance = query.queryItemValue("singleInstance") == "1";
     const bool newClearCookiesAtExit = query.queryItemValue("clearCookiesAtExit") == "1";
+    bool historyLimitOk = false;
+    const int newHistoryMaxEntries = query.queryItemValue("historyMaxEntries").toInt(&historyLimitOk);
+    if (historyLimitOk && newHistoryMaxEntries >= 0) {
+        settings->setHistoryMaxEntries(newHistoryMaxEntries);
+    }
+    const int newHistoryMaxAge = query.queryItemValue("historyMaxAge").toInt(&historyLimitOk);
+    if (historyLimitOk && newHistoryMaxAge >= 0) {
+        settings->setHistoryMaxAgeDays(newHistoryMaxAge);
+    }
+    const int newHistoryMaxSize = query.queryItemValue("historyMaxSize").toInt(&historyLimitOk);
+    if (historyLimitOk && newHistoryMaxSize >= 0) {
+        settings->setHistoryMaxSizeMB(newHistoryMaxSize);
+    }
+    bool restoreCountOk = false;
+    const int newRestoreLoadedTabs = query.queryItemValue("restoreLoadedTabs").toInt(&restoreCountOk);
+    if (restoreCountOk && newRestoreLoadedTabs >= 0) {
+        settings->setRestoreLoadedTabs(newRestoreLoadedTabs);
+    }
     if (!newEnableCookies) {
         newThirdParty = false;
     }
 
-    homeAddress = newHome.isEmpty() ? homeAddress : newHome;
+    // Windows pick up the changes from the settings signals.
+    if (!newHome.isEmpty()) {
+        settings->setHome(newHome);
+    }
     if (!newSearch.isEmpty()) {
-        searchEngine = newSearch;
-    }
-    searchEngineCustom = newCustomSearch;
-    settings.setValue("SearchEngineCustom", searchEngineCustom);
-    openNewTabWithHome = newOpenNewTab;
-    showProgress = newShowProgress;
-    settings.setValue("Home", homeAddress);
-    settings.setValue("SearchEngine", searchEngine);
-    settings.setValue("OpenNewTabWithHome", openNewTabWithHome);
-    settings.setValue("ShowProgressBar", showProgress);
-    settings.setValue("SpatialNavigation", newSpatialNav);
-    settings.setValue("EnableJavaScript", newEnableJs);
-    settings.setValue("LoadImages", newLoadImages);
-    settings.setValue("EnableCookies", newEnableCookies);
-    settings.setValue("EnableThirdPartyCookies", newThirdParty);
-    settings.setValue("AllowPopups", newAllowPopups);
-    settings.setValue("SaveTabs", newSaveTabs);
-    clearCookiesAtExit = newClearCookiesAtExit;
-    settings.setValue("ClearCookiesAtExit", newClearCookiesAtExit);
+        settings->setSearchEngine(newSearch);
+    }
+    settings->setSearchEngineCustom(newCustomSearch);
+    settings->setOpenNewTabWithHome(newOpenNewTab);
+    settings->setShowProgressBar(newShowProgress);
+    settings->setSpatialNavigation(newSpatialNav);
+    settings->setEnableJavaScript(newEnableJs);
+    settings->setLoadImages(newLoadImages);
+    settings->setEnableCookies(newEnableCookies);
+    settings->setEnableThirdPartyCookies(newThirdParty);
+    settings->setAllowPopups(newAllowPopups);
+    settings->setSaveTabs(newSaveTabs);
+    settings->setSingleInstance(newSingleInstance);
+    settings->setClearCookiesAtExit(newClearCookiesAtExit);
     if (newZoom > 0) {
         setZoomPercent(newZoom, true);
     }
-
-    applyWebSettings();
     renderSettingsPage(currentWebView());
     return true;
 }
 
+// The profile is shared by all windows, so the saved settings apply to every page of the process.
 void MainWindow::applyWebSettings()
 {
-    bool spatialNav = settings.value("SpatialNavigation", false).toBool();
-    bool enableJs = settings.value("EnableJavaScript", true).toBool();
-    bool loadImages = settings.value("LoadImages", true).toBool();
-    bool enableCookies = settings.value("EnableCookies", true).toBool();
-    bool enableThirdPartyCookies = settings.value("EnableThirdPartyCookies", true).toBool();
-    bool allowPopups = settings.value("AllowPopups", true).toBool();
-
-    if (args && args->isSet("enable-spatial-navigation")) {
-        spatialNav = true;
-    }
-    if (args && args->isSet("disable-js")) {
-        enableJs = false;
-    }
-    if (args && args->isSet("disable-images")) {
-        loadImages = false;
-    }
+    const bool spatialNav = settings->spatialNavigation();
+    const bool enableJs = settings->enableJavaScript();
+    const bool loadImages = settings->loadImages();
+    const bool enableCookies = settings->enableCookies();
+    const bool enableThirdPartyCookies = settings->enableThirdPartyCookies();
+    const bool allowPopups = settings->allowPopups();
 
+    auto *profile = webProfile;
+    auto *websettings = profile->settings();
     websettings->setAttribute(QWebEngineSettings::SpatialNavigationEnabled, spatialNav);
     websettings->setAttribute(QWebEngineSettings::JavascriptEnabled, enableJs);
     websettings->setAttribute(QWebEngineSettings::AutoLoadImages, loadImages);
     websettings->setAttribute(QWebEngineSettings::LocalStorageEnabled, enableCookies);
     websettings->setAttribute(QWebEngineSettings::JavascriptCanOpenWindows, allowPopups);
 
-    auto *profile = webProfile;
-    profile->setHttpAcceptLanguage(QLocale::system().name());
-
     if (cookiesEnabled && !enableCookies) {
         profile->cookieStore()->deleteAllCookies();
     }
@@ -1723,6 +1582,7 @@ void MainWindow::applyWebSettings()
     profile->setPersistentCookiesPolicy(enableCookies ? QWebEngineProfile::ForcePersistentCookies
                                                      : QWebEngineProfile::NoPersistentCookies);
 
+    QWebEngineScript cookieScript;
     if (!enableCookies) {
         profile->cookieStore()->setCookieFilter([](const QWebEngineCookieStore::FilterRequest &) {
             return false;
@@ -1761,12 +1621,65 @@ void MainWindow::applyWebSettings()
         cookieScript.setWorldId(QWebEngineScript::MainWorld);
     }
 
-    for (int i = 0; i < tabWidget->count(); ++i) {
-        if (auto *view = qobject_cast<WebView *>(tabWidget->widget(i))) {
-            view->page()->scripts().clear();
-            view->page()->scripts().insert(cookieScript);
+    auto *scripts = profile->scripts();
+    for (const QString &name : {QStringLiteral("cookieEnabled"), QStringLiteral("cookieDisabled")}) {
+        for (const QWebEngineScript &script : scripts->find(name)) {
+            scripts->remove(script);
         }
     }
+    scripts->insert(cookieScript);
+}
+
+bool MainWindow::hasCommandLineSettings() const
+{
+    return args
+           && (args->isSet("enable-spatial-navigation") || args->isSet("disable-js")
+               || args->isSet("disable-images"));
+}
+
+// Command line switches apply to the pages of this window only, on top of the profile settings.
+void MainWindow::applyCommandLineSettings(WebView *view)
+{
+    if (!hasCommandLineSettings() || !view) {
+        return;
+    }
+    auto *pageSettings = view->settings();
+    if (args->isSet("enable-spatial-navigation")) {
+        pageSettings->setAttribute(QWebEngineSettings::SpatialNavigationEnabled, true);
+    }
+    if (args->isSet("disable-js")) {
+        pageSettings->setAttribute(QWebEngineSettings::JavascriptEnabled, false);
+    }
+    if (args->isSet("disable-images")) {
+        pageSettings->setAttribute(QWebEngineSettings::AutoLoadImages, false);
+    }
+}
+
+// Every window hears the downloads of the shared profile; the one showing the page takes it.
+void MainWindow::downloadRequested(QWebEngineDownloadRequest *download)
+{
+    // Every window gets the request; exactly one takes it. Without a page to tell, the active
+    // window does, or the first one when none is active.
+    const QWebEnginePage *page = download->page();
+    const auto *view = page ? qobject_cast<const QWidget *>(page->parent()) : nullptr;
+    const QWidget *owner = view ? view->window() : qobject_cast<MainWindow *>(QApplication::activeWindow());
+    if (!owner) {
+        const QWidgetList widgets = QApplication::topLevelWidgets();
+        for (auto it = widgets.cbegin(); !owner && it != widgets.cend(); ++it) {
+            owner = qobject_cast<MainWindow *>(*it);
+        }
+    }
+    if (owner == this) {
+        downloads()->downloadRequested(download);
+    }
+}
+
+DownloadWidget *MainWindow::downloads()
+{
+    if (!downloadWidget) {
+        downloadWidget = new DownloadWidget;
+    }
+    return downloadWidget;
 }
 
 void MainWindow::setZoomPercent(int percent, bool persist)
@@ -1779,12 +1692,13 @@ void MainWindow::setZoomPercent(int percent, bool persist)
         view->setZoomFactor(zoomPercent / 100.0);
     }
     if (persist) {
-        settings.setValue("ZoomPercent", zoomPercent);
+        settings->setZoomPercent(zoomPercent);
     }
 }
 
 void MainWindow::openBookmarksEditor()
 {
+    loadBookmarks();
     QDialog dialog(this);
     dialog.setWindowTitle(tr("Manage bookmarks"));
     dialog.resize(520, 420);
@@ -1901,7 +1815,7 @@ void MainWindow::openBookmarksEditor()
         bookmarks->addAction(bookmark);
         connectAddress(bookmark, bookmarks);
     }
-    saveMenuItems(bookmarks, 2);
+    saveMenuItems(bookmarks);
 }
 
 void MainWindow::closeCurrentTab()
@@ -1915,8 +1829,39 @@ void MainWindow::closeCurrentTab()
 
 void MainWindow::reopenClosedTab()
 {
-    if (!closedTabs.isEmpty()) {
-        openSavedTab(closedTabs.takeLast().first, true);
+    ClosedTabs::Entry entry;
+    if (ClosedTabs::instance()->takeLast(&entry)) {
+        reopenTab(entry);
+    }
+}
+
+// Called before the tab is removed.
+void MainWindow::rememberClosedTab(int index)
+{
+    const QUrl url = tabWidget->tabUrl(index);
+    if (!url.isValid()) {
+        return;
+    }
+    ClosedTabs::Entry entry;
+    entry.url = url;
+    entry.title = tabWidget->tabText(index);
+    entry.iconRef = FaviconStore::instance()->add(tabWidget->tabIcon(index), url.host());
+    if (auto *view = qobject_cast<WebView *>(tabWidget->widget(index))) {
+        entry.history = view->saveHistory();
+    } else if (auto *placeholder = qobject_cast<TabPlaceholder *>(tabWidget->widget(index))) {
+        entry.history = placeholder->history;
+    }
+    ClosedTabs::instance()->add(std::move(entry));
+}
+
+void MainWindow::reopenTab(const ClosedTabs::Entry &entry)
+{
+    openSavedTab(entry.url, true, entry.history);
+    const int index = tabWidget->currentIndex();
+    tabWidget->setTabText(index, entry.title);
+    const QIcon icon = FaviconStore::instance()->icon(entry.iconRef);
+    if (!icon.isNull()) {
+        tabWidget->setTabIcon(index, icon);
     }
 }
 
@@ -1925,6 +1870,16 @@ void MainWindow::openLinkInNewTab(const QUrl &url)
     addNewTab(url, false);
 }
 
+// Open an address or file path as given on the command line in a new current tab.
+void MainWindow::openUrl(const QString &url)
+{
+    if (url.isEmpty()) {
+        addNewTab();
+        return;
+    }
+    addNewTab(QUrl::fromUserInput(QFile::exists(url) ? QFileInfo(url).absoluteFilePath() : url), true);
+}
+
 void MainWindow::toggleFullScreen()
 {
     if (isFullScreen()) {
@@ -1954,61 +1909,86 @@ void MainWindow::updateUrl()
     addressBar->setCursorPosition(0);
 }
 
+// Only the current tab and the RestoreLoadedTabs most recently used ones are loaded, the rest wait as placeholders.
 bool MainWindow::restoreSavedTabs()
 {
-    int size = settings.beginReadArray("SavedTabs");
-    if (size == 0) {
-        settings.endArray();
+    SessionJournal::Session session;
+    if (!SessionJournal::instance()->read(&session)) {
+        // Tabs saved at exit by older versions.
+        QSettings *store = settings->store();
+        const int size = store->beginReadArray("SavedTabs");
+        for (int i = 0; i < size; ++i) {
+            store->setArrayIndex(i);
+            QString url = store->value("url").toString();
+            if (!url.isEmpty()) {
+                session.tabs.append({QUrl::fromUserInput(url), store->value("title").toString(), {},
+                                     store->value("lastActive").toLongLong()});
+            }
+        }
+        store->endArray();
+        store->remove("SavedTabs");
+    }
+    if (session.tabs.isEmpty()) {
         return false;
     }
 
-    QList<QUrl> savedUrls;
-    for (int i = 0; i < size; ++i) {
-        settings.setArrayIndex(i);
-        QString url = settings.value("url").toString();
-        if (!url.isEmpty()) {
-            savedUrls.append(QUrl::fromUserInput(url));
+    QList<int> byRecentUse;
+    for (int i = 0; i < session.tabs.size(); ++i) {
+        if (i != session.current) {
+            byRecentUse.append(i);
         }
     }
-    settings.endArray();
-    settings.remove("SavedTabs");
-
-    if (!savedUrls.isEmpty()) {
-        tabWidget->removeTab(0);
-        openSavedTab(savedUrls.first(), true);
+    std::stable_sort(byRecentUse.begin(), byRecentUse.end(), [&session](int a, int b) {
+        return session.tabs.at(a).lastActive > session.tabs.at(b).lastActive;
+    });
+    const int loadCount = qMax(0, settings->restoreLoadedTabs());
+    QSet<int> loaded(byRecentUse.cbegin(), byRecentUse.cbegin() + qMin<qsizetype>(loadCount, byRecentUse.size()));
+    loaded.insert(session.current);
+
+    // The blank tab stays current until the saved current tab can take over, so no placeholder is shown on the way.
+    for (int i = 0; i < session.tabs.size(); ++i) {
+        const SessionJournal::Tab &tab = session.tabs.at(i);
+        if (loaded.contains(i)) {
+            openSavedTab(tab.url, false, tab.history);
+        } else {
+            tabWidget->addPlaceholder(tab.url, tab.title, FaviconStore::instance()->iconForHost(tab.url.host()),
+                                      tab.history);
+        }
+        tabWidget->widget(tabWidget->count() - 1)->setProperty("lastActive", tab.lastActive);
     }
+    tabWidget->setCurrentIndex(session.current + 1);
+    tabWidget->removeTab(0);
+    return true;
+}
 
-    for (int i = 1; i < savedUrls.size(); ++i) {
-        openSavedTab(savedUrls.at(i), false);
+// With a history stream the tab gets its back and forward list and loads only the current page of it.
+void MainWindow::openSavedTab(const QUrl &url, bool makeCurrent, const QByteArray &history)
+{
+    if (history.isEmpty() && url.scheme() != "mx-history" && url.scheme() != "mx-settings") {
+        addNewTab(url, makeCurrent);
+        return;
+    }
+    auto *view = tabWidget->createTab(makeCurrent);
+    if (!view) {
+        return;
+    }
+    if (makeCurrent) {
+        setConnections();
     }
-    return !savedUrls.isEmpty();
+    loadSavedTab(view, url, makeCurrent, history);
 }
 
-void MainWindow::openSavedTab(const QUrl &url, bool makeCurrent)
+// Internal pages are rendered anew rather than taken from the history. Others are loaded through the
+// scheduler like any tab.
+void MainWindow::loadSavedTab(WebView *view, const QUrl &url, bool foreground, const QByteArray &history)
 {
     if (url.scheme() == "mx-history") {
-        auto *view = tabWidget->createTab(makeCurrent);
-        if (!view) {
-            return;
-        }
-        if (makeCurrent) {
-            setConnections();
-        }
         renderHistoryPage(view);
-        return;
-    }
-    if (url.scheme() == "mx-settings") {
-        auto *view = tabWidget->createTab(makeCurrent);
-        if (!view) {
-            return;
-        }
-        if (makeCurrent) {
-            setConnections();
-        }
+    } else if (url.scheme() == "mx-settings") {
         renderSettingsPage(view);
-        return;
+    } else {
+        LoadScheduler::instance()->load(view, url, foreground, history);
     }
-    addNewTab(url, makeCurrent);
 }
 
 void MainWindow::focusAddressBar()
@@ -2110,23 +2090,11 @@ void MainWindow::resizeEvent(QResizeEvent * /*event*/)
 
 void MainWindow::closeEvent(QCloseEvent * /*event*/)
 {
-    downloadWidget->close();
-    if (clearCookiesAtExit) {
-        webProfile->cookieStore()->deleteAllCookies();
-    }
-    settings.setValue("Geometry", saveGeometry());
-
-    if (settings.value("SaveTabs", false).toBool()) {
-        settings.beginWriteArray("SavedTabs");
-        for (int i = 0; i < tabWidget->count(); ++i) {
-            settings.setArrayIndex(i);
-            auto *webView = qobject_cast<WebView *>(tabWidget->widget(i));
-            if (webView) {
-                settings.setValue("url", webView->url().toString());
-            }
-        }
-        settings.endArray();
+    if (downloadWidget) {
+        downloadWidget->close();
     }
+    settings->setGeometry(saveGeometry());
+    SessionJournal::instance()->detach(tabWidget);
 }
 
 QAction *MainWindow::pageAction(QWebEnginePage::WebAction webAction)
@@ -2165,6 +2133,8 @@ void MainWindow::loading()
 // done loading
 void MainWindow::done(bool ok)
 {
+    StartupTrace::mark("first loadFinished");
+    StartupTrace::finish();
     auto *view = currentWebView();
     if (!view) {
         searchBox->clear();
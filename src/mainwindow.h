@@ -22,17 +22,17 @@
 #pragma once
 
 #include "addressbar.h"
+#include "closedtabs.h"
 #include "downloadwidget.h"
+#include "settings.h"
 #include "tabwidget.h"
 #include "webview.h"
 
 #include <QPointer>
+#include <QTimer>
 
-class QWebEngineSettings;
-class QWebEngineScript;
 class QWebEngineView;
 class QCompleter;
-class QStringListModel;
 
 class MainWindow : public QMainWindow
 {
@@ -45,7 +45,6 @@ public:
 public slots:
     void listHistory();
     void openHistoryPage();
-    bool handleHistoryRequest(const QUrl &url);
     void findBackward();
     void findForward();
     void loading();
@@ -53,6 +52,7 @@ public slots:
     void closeCurrentTab();
     void reopenClosedTab();
     void openLinkInNewTab(const QUrl &url);
+    void openUrl(const QString &url);
     void openDevTools();
     void openSettings();
     bool handleSettingsRequest(const QUrl &url);
@@ -67,6 +67,7 @@ private:
     AddressBar *addressBar {};
     DownloadWidget *downloadWidget {};
     QAction *addBookmark {};
+    QAction *homeAction {};
     QAction *menuButton {};
     QAction *reloadAction {};
     QAction *zoomPercentAction {};
@@ -74,8 +75,6 @@ private:
     QMenu *bookmarks {};
     QMenu *history {};
     QCompleter *historyCompleter {};
-    QStringListModel *historyCompletionModel {};
-    QStringList historyCompletionHosts;
     QProgressBar *progressBar {};
     QString searchEngine;
     QString searchEngineCustom;
@@ -87,29 +86,31 @@ private:
     int lastAddressEditLength {};
     bool lastAddressEditWasDeletion {};
     QByteArray normalGeometry;
-    QSettings settings;
+    Settings *settings {Settings::instance()};
     QString homeAddress;
     QToolBar *toolBar {};
     QWebEngineProfile *webProfile {};
-    QWebEngineSettings *websettings {};
     TabWidget *tabWidget {};
     bool showProgress {};
     bool openNewTabWithHome {};
     int zoomPercent {100};
     bool cookiesEnabled {true};
-    bool clearCookiesAtExit {false};
     bool restoredTabs {};
+    bool bookmarksLoaded {};
     bool clearingCache {};
     const QCommandLineParser *args;
-    QList<QPair<QUrl, QIcon>> closedTabs;
+    // The current page's actions shown in the toolbar; they go away with their page.
+    QPointer<QAction> backAction;
+    QPointer<QAction> forwardAction;
+    QPointer<QAction> stopAction;
     QPointer<QMainWindow> devToolsWindow;
     QPointer<QWebEngineView> devToolsView;
-    QWebEngineScript cookieScript;
     QMetaObject::Connection loadStartedConn;
     QMetaObject::Connection loadingConn;
     QMetaObject::Connection loadFinishedConn;
     QMetaObject::Connection urlChangedConn;
     QMetaObject::Connection linkHoveredConn;
+    QTimer webSettingsTimer;
     static constexpr int defaultHeight {600};
     static constexpr int defaultWidth {800};
     static constexpr int progBarVerticalAdj {40};
@@ -137,36 +138,42 @@ private:
     void setupMenuConnections(QMenu *menu);
     void buildMenu();
     void centerWindow();
-    void clearHistoryEntries();
     void connectAddress(const QAction *action, const QMenu *menu);
     void displaySite(QString url = {}, const QString &title = {});
     void displaySearchResults(const QString &query);
     void openFromAddressBarText(const QString &input);
     QString buildSettingsPageHtml();
-    QString buildHistoryPageHtml();
     void focusAddressBar();
     void focusAddressBarIfBlank();
     void applyWebSettings();
+    [[nodiscard]] bool hasCommandLineSettings() const;
+    void applyCommandLineSettings(WebView *view);
+    void downloadRequested(QWebEngineDownloadRequest *download);
+    DownloadWidget *downloads();
+    void applyHistoryRetention();
     void setZoomPercent(int percent, bool persist);
     void loadBookmarks();
-    void loadHistory();
     void loadSettings();
+    void readSettings();
+    void connectSettings();
     void openBrowseDialog();
     void openQuickInfo();
     void openBookmarksEditor();
     void openFromAddressBar();
     bool isLocalHostInput(const QString &input) const;
     void openSettingsPage();
-    void openSavedTab(const QUrl &url, bool makeCurrent);
-    void removeHistoryEntry(int index);
-    void refreshHistoryCompleter();
+    void openSavedTab(const QUrl &url, bool makeCurrent, const QByteArray &history = {});
+    void rememberClosedTab(int index);
+    void reopenTab(const ClosedTabs::Entry &entry);
+    void loadSavedTab(WebView *view, const QUrl &url, bool foreground, const QByteArray &history = {});
     void renderHistoryPage(WebView *view);
     void renderSettingsPage(WebView *view);
     QString searchUrlForQuery(const QString &query) const;
-    void saveMenuItems(const QMenu *menu, int offset);
+    void saveMenuItems(const QMenu *menu);
     void setConnections();
     void showFullScreenNotification();
     void tabChanged();
+    void showPageAction(QPointer<QAction> *shown, QAction *action, QAction *before);
     void toggleFullScreen();
     void updateUrl();
 };
@@ -0,0 +1,68 @@
+/*****************************************************************************
+ * profileregistry.cpp
+ *****************************************************************************
+ * Copyright (C) 2026 MX Authors
+ *
+ * Authors: Adrian <adrian@mxlinux.org>
+ *          MX Linux <http://mxlinux.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MX Viewer is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MX Viewer.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#include "profileregistry.h"
+#include "historyschemehandler.h"
+#include "settings.h"
+#include "tasksschemehandler.h"
+#include "viewpool.h"
+
+#include <QCoreApplication>
+#include <QLocale>
+#include <QPointer>
+#include <QWebEngineCookieStore>
+#include <QWebEngineProfile>
+#include <QWebEngineSettings>
+
+namespace {
+QPointer<QWebEngineProfile> profile;
+int references {};
+} // namespace
+
+// Settings that are the same for every window are made here once.
+QWebEngineProfile *ProfileRegistry::acquire()
+{
+    ++references;
+    if (!profile) {
+        profile = new QWebEngineProfile("mx-viewer", QCoreApplication::instance());
+        profile->installUrlSchemeHandler("mx-history", new HistorySchemeHandler(profile));
+        profile->installUrlSchemeHandler("mx-tasks", new TasksSchemeHandler(profile));
+        profile->setHttpAcceptLanguage(QLocale::system().name());
+        profile->settings()->setAttribute(QWebEngineSettings::FullScreenSupportEnabled, true);
+        profile->settings()->setAttribute(QWebEngineSettings::DnsPrefetchEnabled, true);
+    }
+    return profile;
+}
+
+// Called from the window destructor, while its pages still exist, so the profile is only deleted
+// once control is back in the event loop.
+void ProfileRegistry::release()
+{
+    if (--references > 0 || !profile) {
+        return;
+    }
+    if (Settings::instance()->clearCookiesAtExit()) {
+        profile->cookieStore()->deleteAllCookies();
+    }
+    ViewPool::instance()->clear();
+    profile->deleteLater();
+    profile = nullptr;
+}
@@ -0,0 +1,35 @@
+/*****************************************************************************
+ * profileregistry.h
+ *****************************************************************************
+ * Copyright (C) 2026 MX Authors
+ *
+ * Authors: Adrian <adrian@mxlinux.org>
+ *          MX Linux <http://mxlinux.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MX Viewer is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MX Viewer.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#pragma once
+
+class QWebEngineProfile;
+
+// The web profile shared by every window of the process, so they share one
+// network context, cookie store and cache. Windows hold a reference while
+// they exist; the profile is set up for the first one and shut down after the
+// last one is gone, clearing cookies first when the user asked for that.
+class ProfileRegistry
+{
+public:
+    [[nodiscard]] static QWebEngineProfile *acquire();
+    static void release();
+};
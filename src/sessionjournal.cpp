@@ -0,0 +1,466 @@
+/*****************************************************************************
+ * sessionjournal.cpp
+ *****************************************************************************
+ * Copyright (C) 2026 MX Authors
+ *
+ * Authors: Adrian <adrian@mxlinux.org>
+ *          MX Linux <http://mxlinux.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MX Viewer is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MX Viewer.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#include "sessionjournal.h"
+#include "tabwidget.h"
+#include "webview.h"
+
+#include <QCoreApplication>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QTabBar>
+
+#include <algorithm>
+
+namespace
+{
+QString dataPath()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+}
+} // namespace
+
+SessionJournal::SessionJournal(QObject *parent)
+    : QObject(parent),
+      fileName(dataPath() + "/session.journal"),
+      lock(dataPath() + "/session.lock")
+{
+    flushTimer.setSingleShot(true);
+    flushTimer.setInterval(flushDelay);
+    connect(&flushTimer, &QTimer::timeout, this, &SessionJournal::flushNavigations);
+    retryTimer.setSingleShot(true);
+    retryTimer.setInterval(retryDelay);
+    connect(&retryTimer, &QTimer::timeout, this, [this] {
+        if (attached && !journal) {
+            compact();
+        }
+    });
+}
+
+SessionJournal::~SessionJournal()
+{
+    detach(attached);
+    if (compactor) {
+        compactor->wait();
+        finishCompaction();
+    }
+}
+
+SessionJournal *SessionJournal::instance()
+{
+    static auto *journal = new SessionJournal(QCoreApplication::instance());
+    return journal;
+}
+
+// Another instance running without single-instance mode leaves the session to the first one.
+bool SessionJournal::ownsFile()
+{
+    if (lock.isLocked()) {
+        return true;
+    }
+    if (!QDir().mkpath(dataPath())) {
+        qWarning() << "Could not create data directory" << dataPath();
+        return false;
+    }
+    return lock.tryLock(0);
+}
+
+// The tabs saved by the last session, in order; current is the one activated last.
+bool SessionJournal::read(Session *session)
+{
+    if (attached || !ownsFile()) {
+        return false;
+    }
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_6_0);
+    quint32 fileMagic = 0;
+    quint32 fileVersion = 0;
+    stream >> fileMagic >> fileVersion;
+    if (fileMagic != magic || fileVersion != version) {
+        return false;
+    }
+    order.clear();
+    states.clear();
+    Record record;
+    while (!stream.atEnd() && decode(stream, &record)) {
+        apply(record);
+    }
+    for (const quint32 id : std::as_const(order)) {
+        const Tab &tab = states[id];
+        if (tab.url.isEmpty()) {
+            continue;
+        }
+        if (!session->tabs.isEmpty() && tab.lastActive > session->tabs.at(session->current).lastActive) {
+            session->current = static_cast<int>(session->tabs.size());
+        }
+        session->tabs.append(tab);
+    }
+    order.clear();
+    states.clear();
+    return !session->tabs.isEmpty();
+}
+
+// Journal the tabs of this window from now on, starting from a snapshot of them.
+bool SessionJournal::attach(TabWidget *tabs)
+{
+    if (!tabs || attached || !ownsFile()) {
+        return false;
+    }
+    attached = tabs;
+    order.clear();
+    states.clear();
+    dirty.clear();
+    lastId = 0;
+    for (int i = 0; i < tabs->count(); ++i) {
+        QWidget *tab = tabs->widget(i);
+        const quint32 id = ++lastId;
+        tab->setProperty("sessionId", id);
+        Tab state {tabs->tabUrl(i), tabs->tabText(i), {}, tab->property("lastActive").toLongLong()};
+        if (auto *view = qobject_cast<WebView *>(tab)) {
+            state.history = view->saveHistory();
+        } else if (const auto *placeholder = qobject_cast<TabPlaceholder *>(tab)) {
+            state.history = placeholder->history;
+        }
+        states.insert(id, state);
+        order.append(id);
+        watchView(tab);
+    }
+    // A view that takes over from a placeholder inherits its id and is not a new tab.
+    connect(tabs, &TabWidget::tabAdded, this, [this](int index) {
+        QWidget *tab = attached->widget(index);
+        if (states.contains(tab->property("sessionId").toUInt())) {
+            return;
+        }
+        const quint32 id = ++lastId;
+        tab->setProperty("sessionId", id);
+        write({RecordType::Open, id, index, attached->tabUrl(index), attached->tabText(index)});
+    });
+    connect(tabs, &TabWidget::tabClosed, this, [this](int index) {
+        if (const quint32 id = tabId(index)) {
+            write({RecordType::Close, id});
+        }
+    });
+    connect(tabs->tabBar(), &QTabBar::tabMoved, this, [this](int /*from*/, int to) {
+        if (const quint32 id = tabId(to)) {
+            write({RecordType::Move, id, to});
+        }
+    });
+    connect(tabs, &QTabWidget::currentChanged, this, [this](int index) {
+        if (const quint32 id = tabId(index)) {
+            write({RecordType::Activate, id, 0, {}, {}, {}, QDateTime::currentMSecsSinceEpoch()});
+        }
+    });
+    connect(tabs, &TabWidget::viewAdded, this, &SessionJournal::watchView);
+    compact();
+    return true;
+}
+
+void SessionJournal::detach(TabWidget *tabs)
+{
+    if (!attached || attached != tabs) {
+        return;
+    }
+    flushNavigations();
+    disconnect(attached, nullptr, this, nullptr);
+    disconnect(attached->tabBar(), nullptr, this, nullptr);
+    attached = nullptr;
+    retryTimer.stop();
+    if (compactor) {
+        compactor->wait();
+        finishCompaction();
+    }
+    delete journal;
+    journal = nullptr;
+}
+
+// Saving tabs was turned off.
+void SessionJournal::clear()
+{
+    detach(attached);
+    if (ownsFile()) {
+        QFile::remove(fileName);
+    }
+}
+
+void SessionJournal::apply(const Record &record)
+{
+    const auto position = [this](qint32 index) { return std::clamp<qsizetype>(index, 0, order.size()); };
+    switch (record.type) {
+    case RecordType::Open:
+        states.insert(record.id, {record.url, record.title, {}, 0});
+        order.removeOne(record.id);
+        order.insert(position(record.index), record.id);
+        break;
+    case RecordType::Close:
+        order.removeOne(record.id);
+        states.remove(record.id);
+        break;
+    case RecordType::Move:
+        if (order.removeOne(record.id)) {
+            order.insert(position(record.index), record.id);
+        }
+        break;
+    case RecordType::Navigate:
+        if (auto it = states.find(record.id); it != states.end()) {
+            it->url = record.url;
+            it->title = record.title;
+            it->history = record.history;
+        }
+        break;
+    case RecordType::Activate:
+        if (auto it = states.find(record.id); it != states.end()) {
+            it->lastActive = record.time;
+        }
+        break;
+    }
+}
+
+// Appended and flushed at once, so the record survives the process being killed. Without a journal
+// after a failed compaction, the records still count and the snapshot of the next try holds them.
+void SessionJournal::write(const Record &record)
+{
+    apply(record);
+    const QByteArray data = encode(record);
+    if (compactor) {
+        pending.append(data);
+        return;
+    }
+    if (!journal) {
+        if (++records >= compactAfter) {
+            compact();
+        }
+        return;
+    }
+    if (journal->write(data) != data.size() || !journal->flush()) {
+        qWarning() << "Could not write session journal" << fileName;
+    }
+    if (++records >= compactAfter) {
+        compact();
+    }
+}
+
+// Replace the file by the records that recreate the current tabs; activations go last, oldest first.
+void SessionJournal::compact()
+{
+    if (compactor) {
+        return;
+    }
+    QByteArray data;
+    QDataStream header(&data, QIODevice::WriteOnly);
+    header.setVersion(QDataStream::Qt_6_0);
+    header << magic << version;
+    for (qsizetype i = 0; i < order.size(); ++i) {
+        const quint32 id = order.at(i);
+        const Tab &tab = states[id];
+        data += encode({RecordType::Open, id, static_cast<qint32>(i), tab.url, tab.title});
+        if (!tab.history.isEmpty()) {
+            data += encode({RecordType::Navigate, id, 0, tab.url, tab.title, tab.history});
+        }
+    }
+    QList<quint32> byActivation = order;
+    std::stable_sort(byActivation.begin(), byActivation.end(),
+                     [this](quint32 a, quint32 b) { return states[a].lastActive < states[b].lastActive; });
+    for (const quint32 id : std::as_const(byActivation)) {
+        if (states[id].lastActive > 0) {
+            data += encode({RecordType::Activate, id, 0, {}, {}, {}, states[id].lastActive});
+        }
+    }
+    records = 0;
+    delete journal;
+    journal = nullptr;
+
+    const QString name = fileName;
+    auto ok = std::make_shared<bool>(false);
+    compacted = ok;
+    auto *thread = QThread::create([data, name, ok] {
+        QSaveFile file(name);
+        *ok = file.open(QIODevice::WriteOnly) && file.write(data) == data.size() && file.commit();
+    });
+    compactor = thread;
+    connect(thread, &QThread::finished, this, [this, thread] {
+        if (compactor == thread) {
+            finishCompaction();
+        }
+    });
+    compactor->start(QThread::LowPriority);
+}
+
+// Called from the thread's finished signal or directly after waiting for the thread.
+// Without the snapshot in place appending would mix this session into the old one, so journaling
+// pauses until a later compaction succeeds; the records made meanwhile are part of its snapshot.
+void SessionJournal::finishCompaction()
+{
+    compactor->deleteLater();
+    compactor = nullptr;
+    const QByteArray data = std::exchange(pending, {});
+    if (!*compacted) {
+        qWarning() << "Could not write session journal" << fileName;
+        if (attached) {
+            retryTimer.start();
+        }
+        return;
+    }
+    journal = new QFile(fileName, this);
+    if (!journal->open(QIODevice::WriteOnly | QIODevice::Append)) {
+        qWarning() << "Could not open session journal" << fileName;
+        delete journal;
+        journal = nullptr;
+        if (attached) {
+            retryTimer.start();
+        }
+        return;
+    }
+    if (!data.isEmpty() && (journal->write(data) != data.size() || !journal->flush())) {
+        qWarning() << "Could not write session journal" << fileName;
+    }
+}
+
+// Navigations of a tab are coalesced: one record with its latest address, title and history.
+void SessionJournal::flushNavigations()
+{
+    flushTimer.stop();
+    const QSet<quint32> ids = std::exchange(dirty, {});
+    for (const quint32 id : ids) {
+        auto *view = qobject_cast<WebView *>(tabWidget(id));
+        if (view && !view->url().isEmpty()) {
+            write({RecordType::Navigate, id, 0, view->url(), view->title(), view->saveHistory()});
+        }
+    }
+}
+
+void SessionJournal::watchView(QWidget *tab)
+{
+    auto *view = qobject_cast<WebView *>(tab);
+    if (!view) {
+        return;
+    }
+    const auto changed = [this, view] {
+        if (!attached || attached->indexOf(view) < 0) {
+            return;
+        }
+        dirty.insert(view->property("sessionId").toUInt());
+        if (!flushTimer.isActive()) {
+            flushTimer.start();
+        }
+    };
+    connect(view, &QWebEngineView::urlChanged, this, changed);
+    connect(view, &QWebEngineView::titleChanged, this, changed);
+    connect(view, &QWebEngineView::loadFinished, this, changed);
+}
+
+quint32 SessionJournal::tabId(int index) const
+{
+    const QWidget *tab = attached ? attached->widget(index) : nullptr;
+    return tab ? tab->property("sessionId").toUInt() : 0;
+}
+
+QWidget *SessionJournal::tabWidget(quint32 id) const
+{
+    if (!attached) {
+        return nullptr;
+    }
+    for (int i = 0; i < attached->count(); ++i) {
+        if (tabId(i) == id) {
+            return attached->widget(i);
+        }
+    }
+    return nullptr;
+}
+
+// A record is framed by its size and a checksum, so a torn or damaged tail is recognized.
+QByteArray SessionJournal::encode(const Record &record)
+{
+    QByteArray payload;
+    QDataStream stream(&payload, QIODevice::WriteOnly);
+    stream.setVersion(QDataStream::Qt_6_0);
+    stream << static_cast<quint8>(record.type) << record.id;
+    switch (record.type) {
+    case RecordType::Open:
+        stream << record.index << record.url << record.title;
+        break;
+    case RecordType::Move:
+        stream << record.index;
+        break;
+    case RecordType::Navigate:
+        stream << record.url << record.title << record.history;
+        break;
+    case RecordType::Activate:
+        stream << record.time;
+        break;
+    case RecordType::Close:
+        break;
+    }
+    QByteArray framed;
+    QDataStream frame(&framed, QIODevice::WriteOnly);
+    frame.setVersion(QDataStream::Qt_6_0);
+    frame << static_cast<quint32>(payload.size()) << qChecksum(payload);
+    return framed + payload;
+}
+
+bool SessionJournal::decode(QDataStream &stream, Record *record)
+{
+    *record = {};
+    quint32 size = 0;
+    quint16 checksum = 0;
+    stream >> size >> checksum;
+    if (stream.status() != QDataStream::Ok || size > stream.device()->bytesAvailable()) {
+        return false;
+    }
+    QByteArray payload(size, Qt::Uninitialized);
+    if (stream.readRawData(payload.data(), static_cast<int>(size)) != static_cast<int>(size)
+        || qChecksum(payload) != checksum) {
+        return false;
+    }
+    QDataStream in(payload);
+    in.setVersion(QDataStream::Qt_6_0);
+    quint8 type = 0;
+    in >> type >> record->id;
+    if (type < static_cast<quint8>(RecordType::Open) || type > static_cast<quint8>(RecordType::Activate)) {
+        return false;
+    }
+    record->type = static_cast<RecordType>(type);
+    switch (record->type) {
+    case RecordType::Open:
+        in >> record->index >> record->url >> record->title;
+        break;
+    case RecordType::Move:
+        in >> record->index;
+        break;
+    case RecordType::Navigate:
+        in >> record->url >> record->title >> record->history;
+        break;
+    case RecordType::Activate:
+        in >> record->time;
+        break;
+    case RecordType::Close:
+        break;
+    }
+    return in.status() == QDataStream::Ok;
+}
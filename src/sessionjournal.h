@@ -0,0 +1,122 @@
+/*****************************************************************************
+ * sessionjournal.h
+ *****************************************************************************
+ * Copyright (C) 2026 MX Authors
+ *
+ * Authors: Adrian <adrian@mxlinux.org>
+ *          MX Linux <http://mxlinux.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MX Viewer is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MX Viewer.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#pragma once
+
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QLockFile>
+#include <QObject>
+#include <QPointer>
+#include <QSet>
+#include <QString>
+#include <QThread>
+#include <QTimer>
+#include <QUrl>
+
+#include <memory>
+
+class QDataStream;
+class QFile;
+class TabWidget;
+
+// Saves the tabs of one window as they change, so a crash loses at most the
+// last moment. Every open, close, move, activation and navigation appends a
+// small checksummed record to session.journal in the data directory;
+// navigations carry the QWebEngineHistory stream of the tab and are written
+// at most every flushDelay per tab. After compactAfter records the file is
+// rewritten in the background as a snapshot of the current tabs, records
+// made meanwhile are appended once it is in place; if that fails, it is
+// retried every retryDelay until it works. Reading replays the
+// records up to the first damaged one. One process owns the journal at a
+// time, through session.lock.
+class SessionJournal : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Tab {
+        QUrl url;
+        QString title;
+        QByteArray history;
+        qint64 lastActive {};
+    };
+    struct Session {
+        QList<Tab> tabs;
+        int current {};
+    };
+
+    static SessionJournal *instance();
+    ~SessionJournal() override;
+
+    bool read(Session *session);
+    bool attach(TabWidget *tabs);
+    void detach(TabWidget *tabs);
+    void clear();
+
+private:
+    explicit SessionJournal(QObject *parent = nullptr);
+
+    enum class RecordType : quint8 { Open = 1, Close, Move, Navigate, Activate };
+    struct Record {
+        RecordType type {};
+        quint32 id {};
+        qint32 index {};
+        QUrl url;
+        QString title;
+        QByteArray history;
+        qint64 time {};
+    };
+
+    QString fileName;
+    QLockFile lock;
+    QPointer<TabWidget> attached;
+    QFile *journal {};
+    QThread *compactor {};
+    std::shared_ptr<bool> compacted;
+    QList<quint32> order;
+    QHash<quint32, Tab> states;
+    QSet<quint32> dirty;
+    QByteArray pending;
+    QTimer flushTimer;
+    QTimer retryTimer;
+    quint32 lastId {};
+    int records {};
+
+    static constexpr quint32 magic {0x4d58534a}; // "MXSJ"
+    static constexpr quint32 version {1};
+    static constexpr int compactAfter {500};
+    static constexpr int flushDelay {500};
+    static constexpr int retryDelay {30000};
+
+    bool ownsFile();
+    void apply(const Record &record);
+    void write(const Record &record);
+    void compact();
+    void finishCompaction();
+    void flushNavigations();
+    void watchView(QWidget *tab);
+    [[nodiscard]] quint32 tabId(int index) const;
+    [[nodiscard]] QWidget *tabWidget(quint32 id) const;
+    [[nodiscard]] static QByteArray encode(const Record &record);
+    static bool decode(QDataStream &stream, Record *record);
+};
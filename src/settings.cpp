@@ -0,0 +1,249 @@
+/*****************************************************************************
+ * settings.cpp
+ *****************************************************************************
+ * Copyright (C) 2026 MX Authors
+ *
+ * Authors: Adrian <adrian@mxlinux.org>
+ *          MX Linux <http://mxlinux.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MX Viewer is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MX Viewer.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#include "settings.h"
+
+#include <QCoreApplication>
+#include <QDebug>
+
+Settings::Settings(QObject *parent)
+    : QObject(parent)
+{
+    values.home = settings.value("Home", "https://start.duckduckgo.com").toString();
+    values.searchEngine = settings.value("SearchEngine", "DuckDuckGo").toString();
+    values.searchEngineCustom = settings.value("SearchEngineCustom").toString();
+    values.openNewTabWithHome = settings.value("OpenNewTabWithHome", true).toBool();
+    values.showProgressBar = settings.value("ShowProgressBar", false).toBool();
+    values.zoomPercent = settings.value("ZoomPercent", 100).toInt();
+    values.spatialNavigation = settings.value("SpatialNavigation", false).toBool();
+    values.enableJavaScript = settings.value("EnableJavaScript", true).toBool();
+    values.loadImages = settings.value("LoadImages", true).toBool();
+    values.enableCookies = settings.value("EnableCookies", true).toBool();
+    values.enableThirdPartyCookies = settings.value("EnableThirdPartyCookies", true).toBool();
+    values.allowPopups = settings.value("AllowPopups", true).toBool();
+    values.saveTabs = settings.value("SaveTabs", false).toBool();
+    values.restoreLoadedTabs = settings.value("RestoreLoadedTabs", 0).toInt();
+    values.singleInstance = settings.value("SingleInstance", false).toBool();
+    values.clearCookiesAtExit = settings.value("ClearCookiesAtExit", false).toBool();
+    values.historyMaxEntries = settings.value("HistoryMaxEntries", defaultHistoryMaxEntries).toInt();
+    values.historyMaxAgeDays = settings.value("HistoryMaxAgeDays", defaultHistoryMaxAgeDays).toInt();
+    values.historyMaxSizeMB = settings.value("HistoryMaxSizeMB", defaultHistoryMaxSizeMB).toInt();
+    values.geometry = settings.value("Geometry").toByteArray();
+    values.downloadGeometry = settings.value("DownloadGeometry").toByteArray();
+    values.backgroundLoadLimit = settings.value("BackgroundLoadLimit", 4).toInt();
+    values.freezeAfterMinutes = settings.value("FreezeAfterMinutes", 10).toInt();
+    values.discardBelowPercent = settings.value("DiscardBelowPercent", 10).toInt();
+
+    saveTimer.setSingleShot(true);
+    saveTimer.setInterval(saveDelay);
+    connect(&saveTimer, &QTimer::timeout, this, &Settings::save);
+
+    // Older versions stored the inverse.
+    if (!settings.contains("EnableJavaScript") && settings.contains("DisableJava")) {
+        setEnableJavaScript(!settings.value("DisableJava", false).toBool());
+    }
+}
+
+Settings::~Settings()
+{
+    save();
+}
+
+Settings *Settings::instance()
+{
+    static auto *settings = new Settings(QCoreApplication::instance());
+    return settings;
+}
+
+// For arrays and keys without a typed value; what is written there is not batched.
+QSettings *Settings::store()
+{
+    return &settings;
+}
+
+void Settings::save()
+{
+    saveTimer.stop();
+    if (pending.isEmpty()) {
+        return;
+    }
+    for (auto it = pending.constBegin(); it != pending.constEnd(); ++it) {
+        settings.setValue(it.key(), it.value());
+    }
+    pending.clear();
+    settings.sync();
+    if (settings.status() != QSettings::NoError) {
+        qWarning() << "Could not write settings" << settings.fileName();
+    }
+}
+
+template <typename T>
+bool Settings::update(T *field, const T &value, const char *key)
+{
+    if (*field == value) {
+        return false;
+    }
+    *field = value;
+    pending.insert(QString::fromLatin1(key), QVariant::fromValue(value));
+    if (!saveTimer.isActive()) {
+        saveTimer.start();
+    }
+    return true;
+}
+
+void Settings::setHome(const QString &value)
+{
+    if (update(&values.home, value, "Home")) {
+        emit homeChanged(value);
+    }
+}
+
+void Settings::setSearchEngine(const QString &value)
+{
+    if (update(&values.searchEngine, value, "SearchEngine")) {
+        emit searchEngineChanged(value);
+    }
+}
+
+void Settings::setSearchEngineCustom(const QString &value)
+{
+    if (update(&values.searchEngineCustom, value, "SearchEngineCustom")) {
+        emit searchEngineCustomChanged(value);
+    }
+}
+
+void Settings::setOpenNewTabWithHome(bool value)
+{
+    if (update(&values.openNewTabWithHome, value, "OpenNewTabWithHome")) {
+        emit openNewTabWithHomeChanged(value);
+    }
+}
+
+void Settings::setShowProgressBar(bool value)
+{
+    if (update(&values.showProgressBar, value, "ShowProgressBar")) {
+        emit showProgressBarChanged(value);
+    }
+}
+
+void Settings::setZoomPercent(int value)
+{
+    if (update(&values.zoomPercent, value, "ZoomPercent")) {
+        emit zoomPercentChanged(value);
+    }
+}
+
+void Settings::setSpatialNavigation(bool value)
+{
+    if (update(&values.spatialNavigation, value, "SpatialNavigation")) {
+        emit spatialNavigationChanged(value);
+    }
+}
+
+void Settings::setEnableJavaScript(bool value)
+{
+    if (update(&values.enableJavaScript, value, "EnableJavaScript")) {
+        emit enableJavaScriptChanged(value);
+    }
+}
+
+void Settings::setLoadImages(bool value)
+{
+    if (update(&values.loadImages, value, "LoadImages")) {
+        emit loadImagesChanged(value);
+    }
+}
+
+void Settings::setEnableCookies(bool value)
+{
+    if (update(&values.enableCookies, value, "EnableCookies")) {
+        emit enableCookiesChanged(value);
+    }
+}
+
+void Settings::setEnableThirdPartyCookies(bool value)
+{
+    if (update(&values.enableThirdPartyCookies, value, "EnableThirdPartyCookies")) {
+        emit enableThirdPartyCookiesChanged(value);
+    }
+}
+
+void Settings::setAllowPopups(bool value)
+{
+    if (update(&values.allowPopups, value, "AllowPopups")) {
+        emit allowPopupsChanged(value);
+    }
+}
+
+void Settings::setSaveTabs(bool value)
+{
+    if (update(&values.saveTabs, value, "SaveTabs")) {
+        emit saveTabsChanged(value);
+    }
+}
+
+void Settings::setRestoreLoadedTabs(int value)
+{
+    update(&values.restoreLoadedTabs, value, "RestoreLoadedTabs");
+}
+
+void Settings::setSingleInstance(bool value)
+{
+    if (update(&values.singleInstance, value, "SingleInstance")) {
+        emit singleInstanceChanged(value);
+    }
+}
+
+void Settings::setClearCookiesAtExit(bool value)
+{
+    update(&values.clearCookiesAtExit, value, "ClearCookiesAtExit");
+}
+
+void Settings::setHistoryMaxEntries(int value)
+{
+    if (update(&values.historyMaxEntries, value, "HistoryMaxEntries")) {
+        emit historyMaxEntriesChanged(value);
+    }
+}
+
+void Settings::setHistoryMaxAgeDays(int value)
+{
+    if (update(&values.historyMaxAgeDays, value, "HistoryMaxAgeDays")) {
+        emit historyMaxAgeDaysChanged(value);
+    }
+}
+
+void Settings::setHistoryMaxSizeMB(int value)
+{
+    if (update(&values.historyMaxSizeMB, value, "HistoryMaxSizeMB")) {
+        emit historyMaxSizeMBChanged(value);
+    }
+}
+
+void Settings::setGeometry(const QByteArray &value)
+{
+    update(&values.geometry, value, "Geometry");
+}
+
+void Settings::setDownloadGeometry(const QByteArray &value)
+{
+    update(&values.downloadGeometry, value, "DownloadGeometry");
+}
@@ -0,0 +1,159 @@
+/*****************************************************************************
+ * settings.h
+ *****************************************************************************
+ * Copyright (C) 2026 MX Authors
+ *
+ * Authors: Adrian <adrian@mxlinux.org>
+ *          MX Linux <http://mxlinux.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MX Viewer is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MX Viewer.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#pragma once
+
+#include <QByteArray>
+#include <QHash>
+#include <QObject>
+#include <QSettings>
+#include <QString>
+#include <QTimer>
+#include <QVariant>
+
+// The settings of the application, read once from the configuration file and
+// shared by every window. Setting a value that windows apply live emits its
+// changed signal when the value differs. Changed values are written back
+// together a moment later and when the application exits. Arrays such as the
+// bookmarks are kept in the underlying QSettings, see store(). Main thread only.
+class Settings : public QObject
+{
+    Q_OBJECT
+
+public:
+    static Settings *instance();
+    ~Settings() override;
+
+    static constexpr int defaultHistoryMaxEntries {100000};
+    static constexpr int defaultHistoryMaxAgeDays {365};
+    static constexpr int defaultHistoryMaxSizeMB {100};
+
+    [[nodiscard]] QString home() const { return values.home; }
+    [[nodiscard]] QString searchEngine() const { return values.searchEngine; }
+    [[nodiscard]] QString searchEngineCustom() const { return values.searchEngineCustom; }
+    [[nodiscard]] bool openNewTabWithHome() const { return values.openNewTabWithHome; }
+    [[nodiscard]] bool showProgressBar() const { return values.showProgressBar; }
+    [[nodiscard]] int zoomPercent() const { return values.zoomPercent; }
+    [[nodiscard]] bool spatialNavigation() const { return values.spatialNavigation; }
+    [[nodiscard]] bool enableJavaScript() const { return values.enableJavaScript; }
+    [[nodiscard]] bool loadImages() const { return values.loadImages; }
+    [[nodiscard]] bool enableCookies() const { return values.enableCookies; }
+    [[nodiscard]] bool enableThirdPartyCookies() const { return values.enableThirdPartyCookies; }
+    [[nodiscard]] bool allowPopups() const { return values.allowPopups; }
+    [[nodiscard]] bool saveTabs() const { return values.saveTabs; }
+    [[nodiscard]] int restoreLoadedTabs() const { return values.restoreLoadedTabs; }
+    [[nodiscard]] bool singleInstance() const { return values.singleInstance; }
+    [[nodiscard]] bool clearCookiesAtExit() const { return values.clearCookiesAtExit; }
+    [[nodiscard]] int historyMaxEntries() const { return values.historyMaxEntries; }
+    [[nodiscard]] int historyMaxAgeDays() const { return values.historyMaxAgeDays; }
+    [[nodiscard]] int historyMaxSizeMB() const { return values.historyMaxSizeMB; }
+    [[nodiscard]] QByteArray geometry() const { return values.geometry; }
+    [[nodiscard]] QByteArray downloadGeometry() const { return values.downloadGeometry; }
+
+    // Only set in the configuration file.
+    [[nodiscard]] int backgroundLoadLimit() const { return values.backgroundLoadLimit; }
+    [[nodiscard]] int freezeAfterMinutes() const { return values.freezeAfterMinutes; }
+    [[nodiscard]] int discardBelowPercent() const { return values.discardBelowPercent; }
+
+    void setHome(const QString &value);
+    void setSearchEngine(const QString &value);
+    void setSearchEngineCustom(const QString &value);
+    void setOpenNewTabWithHome(bool value);
+    void setShowProgressBar(bool value);
+    void setZoomPercent(int value);
+    void setSpatialNavigation(bool value);
+    void setEnableJavaScript(bool value);
+    void setLoadImages(bool value);
+    void setEnableCookies(bool value);
+    void setEnableThirdPartyCookies(bool value);
+    void setAllowPopups(bool value);
+    void setSaveTabs(bool value);
+    void setRestoreLoadedTabs(int value);
+    void setSingleInstance(bool value);
+    void setClearCookiesAtExit(bool value);
+    void setHistoryMaxEntries(int value);
+    void setHistoryMaxAgeDays(int value);
+    void setHistoryMaxSizeMB(int value);
+    void setGeometry(const QByteArray &value);
+    void setDownloadGeometry(const QByteArray &value);
+
+    QSettings *store();
+    void save();
+
+signals:
+    void homeChanged(const QString &value);
+    void searchEngineChanged(const QString &value);
+    void searchEngineCustomChanged(const QString &value);
+    void openNewTabWithHomeChanged(bool value);
+    void showProgressBarChanged(bool value);
+    void zoomPercentChanged(int value);
+    void spatialNavigationChanged(bool value);
+    void enableJavaScriptChanged(bool value);
+    void loadImagesChanged(bool value);
+    void enableCookiesChanged(bool value);
+    void enableThirdPartyCookiesChanged(bool value);
+    void allowPopupsChanged(bool value);
+    void saveTabsChanged(bool value);
+    void singleInstanceChanged(bool value);
+    void historyMaxEntriesChanged(int value);
+    void historyMaxAgeDaysChanged(int value);
+    void historyMaxSizeMBChanged(int value);
+
+private:
+    explicit Settings(QObject *parent = nullptr);
+
+    struct Values {
+        QString home;
+        QString searchEngine;
+        QString searchEngineCustom;
+        bool openNewTabWithHome {};
+        bool showProgressBar {};
+        int zoomPercent {};
+        bool spatialNavigation {};
+        bool enableJavaScript {};
+        bool loadImages {};
+        bool enableCookies {};
+        bool enableThirdPartyCookies {};
+        bool allowPopups {};
+        bool saveTabs {};
+        int restoreLoadedTabs {};
+        bool singleInstance {};
+        bool clearCookiesAtExit {};
+        int historyMaxEntries {};
+        int historyMaxAgeDays {};
+        int historyMaxSizeMB {};
+        QByteArray geometry;
+        QByteArray downloadGeometry;
+        int backgroundLoadLimit {};
+        int freezeAfterMinutes {};
+        int discardBelowPercent {};
+    };
+
+    QSettings settings;
+    Values values;
+    QHash<QString, QVariant> pending;
+    QTimer saveTimer;
+
+    static constexpr int saveDelay {2000};
+
+    template <typename T>
+    bool update(T *field, const T &value, const char *key);
+};
@@ -0,0 +1,134 @@
+/*****************************************************************************
+ * singleinstance.cpp
+ *****************************************************************************
+ * Copyright (C) 2026 MX Authors
+ *
+ * Authors: Adrian <adrian@mxlinux.org>
+ *          MX Linux <http://mxlinux.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MX Viewer is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MX Viewer.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#include "singleinstance.h"
+
+#include <QCoreApplication>
+#include <QDataStream>
+#include <QDebug>
+#include <QFileInfo>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QStandardPaths>
+
+SingleInstance::SingleInstance(QObject *parent)
+    : QObject(parent)
+{
+}
+
+SingleInstance *SingleInstance::instance()
+{
+    static auto *single = new SingleInstance(QCoreApplication::instance());
+    return single;
+}
+
+// In the runtime directory, which is private to the user.
+QString SingleInstance::serverName()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::RuntimeLocation) + '/'
+           + QCoreApplication::applicationName() + ".socket";
+}
+
+// Hand the command line to a running instance. Returns false when there is none or it did not
+// answer, in which case this process carries on by itself.
+bool SingleInstance::forward(const QStringList &arguments)
+{
+    QLocalSocket socket;
+    socket.connectToServer(serverName());
+    if (!socket.waitForConnected(connectTimeout)) {
+        return false;
+    }
+    // Relative file paths mean nothing in the other process.
+    QStringList resolved = arguments;
+    for (qsizetype i = 1; i < resolved.size(); ++i) {
+        if (resolved.at(i).startsWith('-')) {
+            continue;
+        }
+        const QFileInfo file(resolved.at(i));
+        if (file.isRelative() && file.exists()) {
+            resolved[i] = file.absoluteFilePath();
+        }
+        break;
+    }
+    QDataStream out(&socket);
+    out << resolved;
+    if (!socket.waitForBytesWritten(replyTimeout) || !socket.waitForReadyRead(replyTimeout)) {
+        qWarning() << "Running instance did not answer, starting a new one";
+        return false;
+    }
+    return true;
+}
+
+// Listen for later invocations, or stop. Another instance already listening is left alone; a socket
+// left behind by one that crashed is replaced.
+void SingleInstance::setEnabled(bool enabled)
+{
+    if (!enabled) {
+        delete server;
+        server = nullptr;
+        return;
+    }
+    if (server) {
+        return;
+    }
+    server = new QLocalServer(this);
+    server->setSocketOptions(QLocalServer::UserAccessOption);
+    connect(server, &QLocalServer::newConnection, this, [this] {
+        while (QLocalSocket *socket = server->nextPendingConnection()) {
+            connect(socket, &QLocalSocket::disconnected, socket, &QObject::deleteLater);
+            connect(socket, &QLocalSocket::readyRead, this, [this, socket] { readRequest(socket); });
+        }
+    });
+    const QString name = serverName();
+    if (server->listen(name)) {
+        return;
+    }
+    if (server->serverError() == QAbstractSocket::AddressInUseError) {
+        QLocalSocket probe;
+        probe.connectToServer(name);
+        if (probe.waitForConnected(connectTimeout)) {
+            delete server;
+            server = nullptr;
+            return;
+        }
+        QLocalServer::removeServer(name);
+        if (server->listen(name)) {
+            return;
+        }
+    }
+    qWarning() << "Could not listen for other instances:" << server->errorString();
+    delete server;
+    server = nullptr;
+}
+
+void SingleInstance::readRequest(QLocalSocket *socket)
+{
+    QDataStream in(socket);
+    in.startTransaction();
+    QStringList arguments;
+    in >> arguments;
+    if (!in.commitTransaction()) {
+        return;
+    }
+    emit openRequested(arguments);
+    socket->write("1");
+    socket->flush();
+}
@@ -0,0 +1,56 @@
+/*****************************************************************************
+ * singleinstance.h
+ *****************************************************************************
+ * Copyright (C) 2026 MX Authors
+ *
+ * Authors: Adrian <adrian@mxlinux.org>
+ *          MX Linux <http://mxlinux.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MX Viewer is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MX Viewer.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#pragma once
+
+#include <QObject>
+#include <QStringList>
+
+class QLocalServer;
+class QLocalSocket;
+
+// Routes later invocations into the running process. When enabled, the
+// process listens on a per-user local socket; a later invocation sends its
+// command line there and exits, so opening a page costs no browser startup.
+class SingleInstance : public QObject
+{
+    Q_OBJECT
+
+public:
+    static SingleInstance *instance();
+    static bool forward(const QStringList &arguments);
+
+    void setEnabled(bool enabled);
+
+signals:
+    void openRequested(const QStringList &arguments);
+
+private:
+    explicit SingleInstance(QObject *parent = nullptr);
+
+    QLocalServer *server {};
+
+    static constexpr int connectTimeout {200};
+    static constexpr int replyTimeout {3000};
+
+    static QString serverName();
+    void readRequest(QLocalSocket *socket);
+};
@@ -0,0 +1,134 @@
+/*****************************************************************************
+ * startuptrace.cpp
+ *****************************************************************************
+ * Copyright (C) 2026 MX Authors
+ *
+ * Authors: Adrian <adrian@mxlinux.org>
+ *          MX Linux <http://mxlinux.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MX Viewer is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MX Viewer.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#include "startuptrace.h"
+
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QList>
+
+#include <unistd.h>
+
+namespace {
+struct Event {
+    const char *name;
+    char phase;
+    qint64 start; // Nanoseconds since the clock started
+    qint64 duration;
+};
+
+struct Trace {
+    QString path {qEnvironmentVariable("MX_VIEWER_TRACE")};
+    bool recording {!path.isEmpty()};
+    QElapsedTimer clock;
+    QList<Event> events;
+
+    Trace()
+    {
+        if (recording) {
+            clock.start();
+        }
+    }
+};
+
+// Constructed with the other statics, before main() runs.
+Trace trace;
+} // namespace
+
+StartupTrace::Scope::Scope(const char *name)
+    : name(name),
+      start(now())
+{
+}
+
+StartupTrace::Scope::~Scope()
+{
+    if (start >= 0) {
+        record(name, 'X', start, now() - start);
+    }
+}
+
+qint64 StartupTrace::now()
+{
+    return trace.recording ? trace.clock.nsecsElapsed() : -1;
+}
+
+void StartupTrace::record(const char *name, char phase, qint64 start, qint64 duration)
+{
+    if (trace.recording) {
+        trace.events.append({name, phase, start, duration});
+    }
+}
+
+void StartupTrace::begin(const char *name)
+{
+    record(name, 'B', now(), 0);
+}
+
+void StartupTrace::end(const char *name)
+{
+    record(name, 'E', now(), 0);
+}
+
+void StartupTrace::mark(const char *name)
+{
+    record(name, 'i', now(), 0);
+}
+
+// Write the trace and stop recording; later calls do nothing.
+void StartupTrace::finish()
+{
+    if (!trace.recording) {
+        return;
+    }
+    const qint64 end = now();
+    trace.recording = false;
+    const qint64 pid = ::getpid();
+    QJsonArray events;
+    const auto append = [&events, pid](const Event &event) {
+        QJsonObject object {{"name", QString::fromLatin1(event.name)},
+                            {"ph", QString(QLatin1Char(event.phase))},
+                            {"ts", event.start / 1000.0},
+                            {"pid", pid},
+                            {"tid", pid}};
+        if (event.phase == 'X') {
+            object.insert("dur", event.duration / 1000.0);
+        } else if (event.phase == 'i') {
+            object.insert("s", "p");
+        }
+        events.append(object);
+    };
+    append({"startup", 'X', 0, end});
+    for (const Event &event : std::as_const(trace.events)) {
+        append(event);
+    }
+    QFile file(trace.path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)
+        || file.write(QJsonDocument(QJsonObject {{"traceEvents", events}, {"displayTimeUnit", "ms"}}).toJson())
+               < 0) {
+        qWarning() << "Could not write startup trace to" << trace.path;
+    }
+    trace.events.clear();
+}
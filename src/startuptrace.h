@@ -0,0 +1,57 @@
+/*****************************************************************************
+ * startuptrace.h
+ *****************************************************************************
+ * Copyright (C) 2026 MX Authors
+ *
+ * Authors: Adrian <adrian@mxlinux.org>
+ *          MX Linux <http://mxlinux.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MX Viewer is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MX Viewer.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#pragma once
+
+#include <QtGlobal>
+
+// Opt-in timeline of startup phases. When MX_VIEWER_TRACE names a file,
+// phases are timed with a monotonic clock from process start until the
+// first page finishes loading, then written there as Chrome trace events
+// for chrome://tracing or Perfetto. Otherwise every call is a no-op.
+// Main thread only.
+class StartupTrace
+{
+public:
+    // Times the enclosing block as one phase.
+    class Scope
+    {
+    public:
+        explicit Scope(const char *name);
+        ~Scope();
+        Scope(const Scope &) = delete;
+        Scope &operator=(const Scope &) = delete;
+
+    private:
+        const char *name;
+        qint64 start {-1};
+    };
+
+    // For phases that do not fit a block; every begin needs an end.
+    static void begin(const char *name);
+    static void end(const char *name);
+    static void mark(const char *name);
+    static void finish();
+
+private:
+    static qint64 now();
+    static void record(const char *name, char phase, qint64 start, qint64 duration);
+};
@@ -0,0 +1,212 @@
+/*****************************************************************************
+ * tablifecycle.cpp
+ *****************************************************************************
+ * Copyright (C) 2026 MX Authors
+ *
+ * Authors: Adrian <adrian@mxlinux.org>
+ *          MX Linux <http://mxlinux.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MX Viewer is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MX Viewer.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#include "tablifecycle.h"
+#include "settings.h"
+#include "webview.h"
+
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QFile>
+#include <QLoggingCategory>
+
+Q_LOGGING_CATEGORY(lcLifecycle, "mx.viewer.lifecycle", QtWarningMsg)
+
+TabLifecycle::TabLifecycle(QObject *parent)
+    : QObject(parent)
+{
+    const auto *settings = Settings::instance();
+    freezeAfter = settings->freezeAfterMinutes() * 60LL * 1000;
+    discardBelowPercent = settings->discardBelowPercent();
+    checkTimer.setInterval(checkInterval);
+    connect(&checkTimer, &QTimer::timeout, this, &TabLifecycle::check);
+}
+
+TabLifecycle *TabLifecycle::instance()
+{
+    static auto *lifecycle = new TabLifecycle(QCoreApplication::instance());
+    return lifecycle;
+}
+
+// Start managing the view of a tab; the timer only runs while there are views.
+void TabLifecycle::watch(WebView *view)
+{
+    if (!view || views.contains(view)) {
+        return;
+    }
+    view->setProperty("tabId", ++lastTabId);
+    if (!view->property("lastActive").isValid()) {
+        view->setProperty("lastActive", QDateTime::currentMSecsSinceEpoch());
+    }
+    views.append(view);
+    if (!checkTimer.isActive()) {
+        checkTimer.start();
+    }
+}
+
+// The tab is shown again; a discarded page reloads when it becomes active.
+void TabLifecycle::activate(WebView *view)
+{
+    if (!view) {
+        return;
+    }
+    view->setProperty("lastActive", QDateTime::currentMSecsSinceEpoch());
+    if (view->page()->lifecycleState() != QWebEnginePage::LifecycleState::Active) {
+        view->page()->setLifecycleState(QWebEnginePage::LifecycleState::Active);
+    }
+}
+
+TabLifecycle::Stats TabLifecycle::stats() const
+{
+    return counters;
+}
+
+// The views of all open tabs, in every window.
+QList<WebView *> TabLifecycle::tabs() const
+{
+    QList<WebView *> result;
+    for (const auto &view : views) {
+        if (view) {
+            result.append(view);
+        }
+    }
+    return result;
+}
+
+WebView *TabLifecycle::tab(int id) const
+{
+    for (const auto &view : views) {
+        if (view && tabId(view) == id) {
+            return view;
+        }
+    }
+    return nullptr;
+}
+
+// Stable for the life of the tab, for pages that refer to tabs.
+int TabLifecycle::tabId(const WebView *view)
+{
+    return view->property("tabId").toInt();
+}
+
+void TabLifecycle::check()
+{
+    views.removeIf([](const QPointer<WebView> &view) { return !view; });
+    if (views.isEmpty()) {
+        checkTimer.stop();
+        return;
+    }
+    // Visible tabs are in use, so the last use of a hidden tab is known to within one check.
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    for (const auto &view : std::as_const(views)) {
+        if (view->isVisible()) {
+            view->setProperty("lastActive", now);
+        } else if (freezeAfter > 0 && isIdle(view) && now - lastActive(view) >= freezeAfter) {
+            freeze(view);
+        }
+    }
+    const bool low = discardBelowPercent > 0 && memoryLow();
+    if (low) {
+        if (auto *view = leastRecentlyUsed()) {
+            discard(view);
+        }
+    }
+    checkTimer.setInterval(low ? pressureInterval : checkInterval);
+}
+
+bool TabLifecycle::freeze(WebView *view)
+{
+    auto *page = view->page();
+    if (page->lifecycleState() != QWebEnginePage::LifecycleState::Active
+        || page->recommendedState() == QWebEnginePage::LifecycleState::Active) {
+        return false;
+    }
+    page->setLifecycleState(QWebEnginePage::LifecycleState::Frozen);
+    ++counters.freezes;
+    qCDebug(lcLifecycle) << "froze" << view->url().toString() << "freezes" << counters.freezes;
+    return true;
+}
+
+bool TabLifecycle::discard(WebView *view)
+{
+    if (!view || !isIdle(view)) {
+        return false;
+    }
+    auto *page = view->page();
+    if (page->lifecycleState() == QWebEnginePage::LifecycleState::Discarded
+        || page->recommendedState() != QWebEnginePage::LifecycleState::Discarded) {
+        return false;
+    }
+    page->setLifecycleState(QWebEnginePage::LifecycleState::Discarded);
+    ++counters.discards;
+    qCDebug(lcLifecycle) << "discarded" << view->url().toString() << "discards" << counters.discards;
+    return true;
+}
+
+WebView *TabLifecycle::leastRecentlyUsed() const
+{
+    WebView *oldest {};
+    for (const auto &view : views) {
+        if (!view || !isIdle(view)
+            || view->page()->lifecycleState() == QWebEnginePage::LifecycleState::Discarded
+            || view->page()->recommendedState() != QWebEnginePage::LifecycleState::Discarded) {
+            continue;
+        }
+        if (!oldest || lastActive(view) < lastActive(oldest)) {
+            oldest = view;
+        }
+    }
+    return oldest;
+}
+
+// Hidden and showing a page; a blank tab has nothing to give back.
+bool TabLifecycle::isIdle(const WebView *view)
+{
+    return !view->isVisible() && !view->url().isEmpty();
+}
+
+qint64 TabLifecycle::lastActive(const WebView *view)
+{
+    return view->property("lastActive").toLongLong();
+}
+
+bool TabLifecycle::memoryLow() const
+{
+    QFile file("/proc/meminfo");
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    // Files in /proc report no size, so read them whole rather than testing atEnd().
+    qint64 total = -1;
+    qint64 available = -1;
+    for (const QByteArray &line : file.readAll().split('\n')) {
+        const QList<QByteArray> fields = line.simplified().split(' ');
+        if (fields.size() < 2) {
+            continue;
+        }
+        if (fields.first() == "MemTotal:") {
+            total = fields.at(1).toLongLong();
+        } else if (fields.first() == "MemAvailable:") {
+            available = fields.at(1).toLongLong();
+        }
+    }
+    return total > 0 && available >= 0 && available * 100 < total * discardBelowPercent;
+}
@@ -0,0 +1,77 @@
+/*****************************************************************************
+ * tablifecycle.h
+ *****************************************************************************
+ * Copyright (C) 2026 MX Authors
+ *
+ * Authors: Adrian <adrian@mxlinux.org>
+ *          MX Linux <http://mxlinux.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MX Viewer is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MX Viewer.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#pragma once
+
+#include <QList>
+#include <QObject>
+#include <QPointer>
+#include <QTimer>
+
+class WebView;
+
+// Puts the renderers of hidden tabs to rest. A tab left in the background
+// for FreezeAfterMinutes is frozen: it keeps its memory but runs no more
+// script or timers. While MemAvailable in /proc/meminfo is under
+// DiscardBelowPercent of the total, the least recently used hidden tab is
+// discarded every few seconds, giving up its renderer; it reloads when shown.
+// Tabs whose page asks to stay active (playing audio, open devtools) are left
+// alone, as QWebEnginePage::recommendedState() says.
+class TabLifecycle : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Stats {
+        int freezes {};
+        int discards {};
+    };
+
+    static TabLifecycle *instance();
+
+    void watch(WebView *view);
+    void activate(WebView *view);
+    bool discard(WebView *view);
+    [[nodiscard]] Stats stats() const;
+    [[nodiscard]] QList<WebView *> tabs() const;
+    [[nodiscard]] WebView *tab(int id) const;
+    [[nodiscard]] static int tabId(const WebView *view);
+
+private:
+    explicit TabLifecycle(QObject *parent = nullptr);
+
+    QList<QPointer<WebView>> views;
+    QTimer checkTimer;
+    Stats counters;
+    qint64 freezeAfter {};
+    int lastTabId {};
+    int discardBelowPercent {};
+
+    static constexpr int checkInterval {30000};
+    static constexpr int pressureInterval {5000};
+
+    void check();
+    bool freeze(WebView *view);
+    [[nodiscard]] WebView *leastRecentlyUsed() const;
+    [[nodiscard]] static bool isIdle(const WebView *view);
+    [[nodiscard]] static qint64 lastActive(const WebView *view);
+    [[nodiscard]] bool memoryLow() const;
+};
@@ -20,8 +20,12 @@
  * along with this package. If not, see <http://www.gnu.org/licenses/>.
  **********************************************************************/
 #include "tabwidget.h"
+#include "loadscheduler.h"
+#include "tablifecycle.h"
+#include "viewpool.h"
 
 #include <QApplication>
+#include <QDateTime>
 #include <QEvent>
 #include <QMouseEvent>
 #include <QMessageBox>
@@ -74,8 +78,19 @@ bool TabWidget::eventFilter(QObject *obj, QEvent *event)
 
 void TabWidget::handleCurrentChanged(int index)
 {
+    if (qobject_cast<TabPlaceholder *>(widget(index))) {
+        activatePlaceholder(index);
+        return;
+    }
+    if (auto *w = widget(index)) {
+        w->setProperty("lastActive", QDateTime::currentMSecsSinceEpoch());
+    }
     auto *webView = currentWebView();
     if (webView) {
+        TabLifecycle::instance()->activate(webView);
+        LoadScheduler::instance()->promote(webView);
+    }
+    if (webView && !webView->title().isEmpty()) {
         setTabText(index, webView->title());
     }
 }
@@ -138,17 +153,16 @@ void TabWidget::finalizeRemoveTab(int index)
         updateNewTabButton();
         return;
     }
-    if (auto *webView = qobject_cast<WebView *>(w)) {
-        emit tabClosed(webView->url());
-    }
+    emit tabClosed(index);
     QTabWidget::removeTab(index);
     w->deleteLater();
     updateNewTabButton();
 }
 
-WebView *TabWidget::createTab(bool makeCurrent)
+// The view comes from the spare pool; it has url loaded already if that was the page preloaded.
+WebView *TabWidget::createTab(bool makeCurrent, const QUrl &url)
 {
-    QPointer<WebView> webView = new WebView(profile);
+    QPointer<WebView> webView = ViewPool::instance()->take(profile, url);
     addNewTab(webView, makeCurrent);
     return webView.data();
 }
@@ -159,6 +173,58 @@ void TabWidget::addNewTab(WebView *webView, bool makeCurrent)
     if (makeCurrent) {
         setCurrentIndex(tab);
     }
+    connectView(webView);
+    updateNewTabButton();
+    QTimer::singleShot(0, this, &TabWidget::positionNewTabButton);
+}
+
+void TabWidget::addPlaceholder(const QUrl &url, const QString &title, const QIcon &icon, const QByteArray &history)
+{
+    addTab(new TabPlaceholder(url, history), icon, title.isEmpty() ? url.toString() : title);
+    updateNewTabButton();
+    QTimer::singleShot(0, this, &TabWidget::positionNewTabButton);
+}
+
+// Put a real view in place of the placeholder; whoever handles placeholderActivated loads the page.
+// Dynamic properties, such as the last activation time, carry over to the view.
+void TabWidget::activatePlaceholder(int index)
+{
+    auto *placeholder = qobject_cast<TabPlaceholder *>(widget(index));
+    if (!placeholder) {
+        return;
+    }
+    WebView *webView = ViewPool::instance()->take(profile);
+    for (const QByteArray &name : placeholder->dynamicPropertyNames()) {
+        webView->setProperty(name, placeholder->property(name));
+    }
+    insertTab(index, webView, tabIcon(index), tabText(index));
+    connectView(webView);
+    setCurrentIndex(index);
+    QTabWidget::removeTab(index + 1);
+    placeholder->deleteLater();
+    emit placeholderActivated(webView, placeholder);
+}
+
+void TabWidget::tabInserted(int index)
+{
+    QTabWidget::tabInserted(index);
+    emit tabAdded(index);
+}
+
+QUrl TabWidget::tabUrl(int index) const
+{
+    if (auto *webView = qobject_cast<WebView *>(widget(index))) {
+        return webView->url();
+    }
+    if (auto *placeholder = qobject_cast<TabPlaceholder *>(widget(index))) {
+        return placeholder->url;
+    }
+    return {};
+}
+
+void TabWidget::connectView(WebView *webView)
+{
+    TabLifecycle::instance()->watch(webView);
     connect(webView, &WebView::titleChanged, this, [this, webView] {
         if (webView) {
             setTabText(indexOf(webView), webView->title());
@@ -172,8 +238,7 @@ void TabWidget::addNewTab(WebView *webView, bool makeCurrent)
     connect(webView, &WebView::newWebView, this, [this](WebView *view, bool makeCurrent) {
         addNewTab(view, makeCurrent);
     });
-    updateNewTabButton();
-    QTimer::singleShot(0, this, &TabWidget::positionNewTabButton);
+    emit viewAdded(webView);
 }
 
 void TabWidget::keyPressEvent(QKeyEvent *event)
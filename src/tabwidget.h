@@ -27,6 +27,22 @@
 
 class QPushButton;
 
+// Stand-in for a restored tab that keeps only its address and history stream until the tab is first shown.
+class TabPlaceholder : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit TabPlaceholder(const QUrl &url, const QByteArray &history = {}, QWidget *parent = nullptr)
+        : QWidget(parent),
+          url(url),
+          history(history)
+    {
+    }
+    const QUrl url;
+    const QByteArray history;
+};
+
 class TabWidget : public QTabWidget
 {
     Q_OBJECT
@@ -35,22 +51,30 @@ public:
     explicit TabWidget(QWebEngineProfile *profile, QWidget *parent = nullptr);
     WebView *currentWebView();
 
-    WebView *createTab(bool makeCurrent = true);
+    WebView *createTab(bool makeCurrent = true, const QUrl &url = {});
     void addNewTab(WebView *webView, bool makeCurrent = true);
+    void addPlaceholder(const QUrl &url, const QString &title, const QIcon &icon, const QByteArray &history = {});
+    [[nodiscard]] QUrl tabUrl(int index) const;
     void removeTab(int index);
 
 protected:
+    void tabInserted(int index) override;
     void keyPressEvent(QKeyEvent *event) override;
     void mousePressEvent(QMouseEvent *event) override;
     bool eventFilter(QObject *obj, QEvent *event) override;
 
 signals:
     void newTabButtonClicked();
-    void tabClosed(const QUrl &url);
+    void viewAdded(WebView *view);
+    void tabAdded(int index);
+    void tabClosed(int index);
+    void placeholderActivated(WebView *view, const TabPlaceholder *placeholder);
 
 private:
     QPushButton *newTabButton {};
     QWebEngineProfile *profile {};
+    void activatePlaceholder(int index);
+    void connectView(WebView *webView);
     void handleCurrentChanged(int index);
     void finalizeRemoveTab(int index);
     void updateNewTabButton();
@@ -0,0 +1,133 @@
+/*****************************************************************************
+ * tasksampler.cpp
+ *****************************************************************************
+ * Copyright (C) 2026 MX Authors
+ *
+ * Authors: Adrian <adrian@mxlinux.org>
+ *          MX Linux <http://mxlinux.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MX Viewer is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MX Viewer.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#include "tasksampler.h"
+#include "tablifecycle.h"
+#include "webview.h"
+
+#include <QCoreApplication>
+#include <QFile>
+
+#include <unistd.h>
+
+TaskSampler::TaskSampler(QObject *parent)
+    : QObject(parent)
+{
+    timer.setInterval(interval);
+    connect(&timer, &QTimer::timeout, this, &TaskSampler::sampleAll);
+    clock.start();
+}
+
+TaskSampler *TaskSampler::instance()
+{
+    static auto *sampler = new TaskSampler(QCoreApplication::instance());
+    return sampler;
+}
+
+// The latest figures for pid. The first request after a pause samples at once.
+TaskSampler::Sample TaskSampler::sample(qint64 pid)
+{
+    sinceRequest.start();
+    if (!timer.isActive()) {
+        timer.start();
+        sampleAll();
+    }
+    return samples.value(pid);
+}
+
+void TaskSampler::sampleAll()
+{
+    if (sinceRequest.hasExpired(idleAfter)) {
+        timer.stop();
+        samples.clear();
+        return;
+    }
+    const qint64 now = clock.elapsed();
+    const qint64 elapsed = now - lastSampled;
+    lastSampled = now;
+    QHash<qint64, Sample> current;
+    for (const WebView *view : TabLifecycle::instance()->tabs()) {
+        const qint64 pid = view->page()->renderProcessPid();
+        if (pid <= 0 || current.contains(pid)) {
+            continue;
+        }
+        Sample sample;
+        readMemory(pid, &sample);
+        sample.cpuTime = readCpuTime(pid);
+        const auto previous = samples.constFind(pid);
+        if (previous != samples.constEnd() && previous->cpuTime >= 0 && sample.cpuTime >= 0 && elapsed > 0) {
+            const auto used = static_cast<double>(sample.cpuTime - previous->cpuTime);
+            sample.cpuPercent = 100.0 * used / static_cast<double>(elapsed);
+        }
+        current.insert(pid, sample);
+    }
+    samples = current;
+}
+
+// smaps_rollup (Linux 4.14) has both figures in one read; older kernels only give RSS through statm.
+bool TaskSampler::readMemory(qint64 pid, Sample *sample)
+{
+    QFile rollup(QString("/proc/%1/smaps_rollup").arg(pid));
+    if (rollup.open(QIODevice::ReadOnly)) {
+        for (const QByteArray &line : rollup.readAll().split('\n')) {
+            const QList<QByteArray> fields = line.simplified().split(' ');
+            if (fields.size() < 2) {
+                continue;
+            }
+            if (fields.first() == "Rss:") {
+                sample->rss = fields.at(1).toLongLong() * 1024;
+            } else if (fields.first() == "Pss:") {
+                sample->pss = fields.at(1).toLongLong() * 1024;
+            }
+        }
+        return sample->rss >= 0;
+    }
+    QFile statm(QString("/proc/%1/statm").arg(pid));
+    if (!statm.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    const QList<QByteArray> fields = statm.readAll().simplified().split(' ');
+    if (fields.size() < 2) {
+        return false;
+    }
+    sample->rss = fields.at(1).toLongLong() * sysconf(_SC_PAGESIZE);
+    return true;
+}
+
+// User plus system time, fields 14 and 15 of stat. The command name may contain spaces, so count from its ')'.
+qint64 TaskSampler::readCpuTime(qint64 pid)
+{
+    QFile stat(QString("/proc/%1/stat").arg(pid));
+    if (!stat.open(QIODevice::ReadOnly)) {
+        return -1;
+    }
+    const QByteArray data = stat.readAll();
+    const qsizetype end = data.lastIndexOf(')');
+    if (end < 0) {
+        return -1;
+    }
+    const QList<QByteArray> fields = data.mid(end + 2).simplified().split(' ');
+    if (fields.size() < 13) {
+        return -1;
+    }
+    const qint64 ticks = fields.at(11).toLongLong() + fields.at(12).toLongLong();
+    return ticks * 1000 / sysconf(_SC_CLK_TCK);
+}
@@ -0,0 +1,64 @@
+/*****************************************************************************
+ * tasksampler.h
+ *****************************************************************************
+ * Copyright (C) 2026 MX Authors
+ *
+ * Authors: Adrian <adrian@mxlinux.org>
+ *          MX Linux <http://mxlinux.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MX Viewer is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MX Viewer.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#pragma once
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QObject>
+#include <QTimer>
+
+// Memory and CPU use of the renderer processes, read from /proc. Sampling
+// only runs while someone asks for samples: each request keeps the timer
+// going for a few more intervals, so with the task page closed it stops.
+// Tabs of the same site may share a renderer and then show the same figures.
+class TaskSampler : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Sample {
+        qint64 rss {-1}; // Bytes
+        qint64 pss {-1}; // Bytes, -1 where the kernel has no smaps_rollup
+        qint64 cpuTime {-1}; // Milliseconds since the process started
+        double cpuPercent {}; // Over the last interval, of one core
+    };
+
+    static TaskSampler *instance();
+
+    [[nodiscard]] Sample sample(qint64 pid);
+
+private:
+    explicit TaskSampler(QObject *parent = nullptr);
+
+    QHash<qint64, Sample> samples;
+    QTimer timer;
+    QElapsedTimer clock;
+    QElapsedTimer sinceRequest;
+    qint64 lastSampled {};
+
+    static constexpr int interval {2000};
+    static constexpr int idleAfter {3 * interval};
+
+    void sampleAll();
+    static bool readMemory(qint64 pid, Sample *sample);
+    static qint64 readCpuTime(qint64 pid);
+};
@@ -0,0 +1,342 @@
+/*****************************************************************************
+ * tasksschemehandler.cpp
+ *****************************************************************************
+ * Copyright (C) 2026 MX Authors
+ *
+ * Authors: Adrian <adrian@mxlinux.org>
+ *          MX Linux <http://mxlinux.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MX Viewer is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MX Viewer.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#include "tasksschemehandler.h"
+#include "loadscheduler.h"
+#include "tablifecycle.h"
+#include "tabwidget.h"
+#include "tasksampler.h"
+#include "webview.h"
+
+#include <QBuffer>
+#include <QCoreApplication>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QUrlQuery>
+#include <QWebEngineUrlRequestJob>
+#include <QWebEngineUrlScheme>
+
+TasksSchemeHandler::TasksSchemeHandler(QObject *parent)
+    : QWebEngineUrlSchemeHandler(parent)
+{
+}
+
+// Must be called before the QApplication is created.
+void TasksSchemeHandler::registerScheme()
+{
+    QWebEngineUrlScheme scheme("mx-tasks");
+    scheme.setSyntax(QWebEngineUrlScheme::Syntax::Host);
+    scheme.setFlags(QWebEngineUrlScheme::SecureScheme | QWebEngineUrlScheme::LocalScheme
+                    | QWebEngineUrlScheme::LocalAccessAllowed);
+    QWebEngineUrlScheme::registerScheme(scheme);
+}
+
+void TasksSchemeHandler::requestStarted(QWebEngineUrlRequestJob *job)
+{
+    const QUrl url = job->requestUrl();
+    if (url.host() != "list") {
+        job->fail(QWebEngineUrlRequestJob::UrlNotFound);
+        return;
+    }
+    const QString path = url.path();
+    // Only the page itself may be opened from elsewhere.
+    if (!path.isEmpty() && path != "/" && !isOwnRequest(job)) {
+        job->fail(QWebEngineUrlRequestJob::RequestDenied);
+        return;
+    }
+    auto *lifecycle = TabLifecycle::instance();
+    const int id = QUrlQuery(url).queryItemValue("id").toInt();
+    if (path.isEmpty() || path == "/") {
+        reply(job, "text/html", pageHtml());
+    } else if (path == "/tabs") {
+        reply(job, "application/json", tabsJson());
+    } else if ((path == "/close" || path == "/discard") && job->requestMethod() == "POST") {
+        const bool ok = path == "/close" ? closeTab(id) : lifecycle->discard(lifecycle->tab(id));
+        reply(job, "application/json", QJsonDocument(QJsonObject {{"ok", ok}}).toJson(QJsonDocument::Compact));
+    } else {
+        job->fail(QWebEngineUrlRequestJob::UrlNotFound);
+    }
+}
+
+// Made by the page of this scheme, not by another page or site posting to it.
+bool TasksSchemeHandler::isOwnRequest(const QWebEngineUrlRequestJob *job)
+{
+    const QUrl initiator = job->initiator();
+    return initiator.scheme() == "mx-tasks" && initiator.host() == "list";
+}
+
+void TasksSchemeHandler::reply(QWebEngineUrlRequestJob *job, const QByteArray &contentType, const QByteArray &data)
+{
+    auto *buffer = new QBuffer(job);
+    buffer->setData(data);
+    buffer->open(QIODevice::ReadOnly);
+    job->reply(contentType, buffer);
+}
+
+// The last tab of a window closes the window, as closing it from the tab bar would leave an empty one.
+bool TasksSchemeHandler::closeTab(int id)
+{
+    WebView *view = TabLifecycle::instance()->tab(id);
+    if (!view) {
+        return false;
+    }
+    for (QWidget *parent = view->parentWidget(); parent; parent = parent->parentWidget()) {
+        if (auto *tabs = qobject_cast<TabWidget *>(parent)) {
+            if (tabs->count() == 1) {
+                return tabs->window()->close();
+            }
+            tabs->removeTab(tabs->indexOf(view));
+            return true;
+        }
+    }
+    return false;
+}
+
+// Sizes in bytes, CPU time in milliseconds; -1 where a figure is unknown, e.g. for a discarded tab.
+QByteArray TasksSchemeHandler::tabsJson()
+{
+    const auto stateName = [](QWebEnginePage::LifecycleState state) {
+        switch (state) {
+        case QWebEnginePage::LifecycleState::Frozen:
+            return QStringLiteral("frozen");
+        case QWebEnginePage::LifecycleState::Discarded:
+            return QStringLiteral("discarded");
+        case QWebEnginePage::LifecycleState::Active:
+            break;
+        }
+        return QStringLiteral("active");
+    };
+    auto *sampler = TaskSampler::instance();
+    QJsonArray tabs;
+    for (const WebView *view : TabLifecycle::instance()->tabs()) {
+        const qint64 pid = view->page()->renderProcessPid();
+        const TaskSampler::Sample sample = pid > 0 ? sampler->sample(pid) : TaskSampler::Sample {};
+        tabs.append(QJsonObject {
+            {"id", TabLifecycle::tabId(view)},
+            {"title", view->title().isEmpty() ? view->url().toString() : view->title()},
+            {"url", view->url().toString()},
+            {"pid", pid},
+            {"rss", sample.rss},
+            {"pss", sample.pss},
+            {"cpuTime", sample.cpuTime},
+            {"cpu", sample.cpuPercent},
+            {"state", stateName(view->page()->lifecycleState())},
+            {"visible", view->isVisible()},
+        });
+    }
+    const LoadScheduler::Stats loads = LoadScheduler::instance()->stats();
+    const TabLifecycle::Stats lifecycle = TabLifecycle::instance()->stats();
+    const QJsonObject result {
+        {"tabs", tabs},
+        {"queued", loads.queued},
+        {"maxWait", loads.maxWait},
+        {"freezes", lifecycle.freezes},
+        {"discards", lifecycle.discards},
+    };
+    return QJsonDocument(result).toJson(QJsonDocument::Compact);
+}
+
+// Strings use the MainWindow context like the history page
+QByteArray TasksSchemeHandler::pageHtml()
+{
+    const QJsonObject strings {
+        {"close", QCoreApplication::translate("MainWindow", "Close")},
+        {"discard", QCoreApplication::translate("MainWindow", "Discard")},
+        {"active", QCoreApplication::translate("MainWindow", "Active")},
+        {"frozen", QCoreApplication::translate("MainWindow", "Frozen")},
+        {"discarded", QCoreApplication::translate("MainWindow", "Discarded")},
+        {"summary", QCoreApplication::translate("MainWindow",
+                                                "Queued loads: %1, longest wait: %2 ms, frozen: %3, discarded: %4")},
+    };
+    const QString html = QStringLiteral(R"(<!doctype html>
+<html>
+<head>
+  <meta charset="utf-8">
+  <title>%1</title>
+  <style>
+    :root { color-scheme: light; }
+    body { font-family: sans-serif; margin: 24px; color: #1f2328; background: #ffffff; }
+    h1 { font-size: 22px; margin: 0 0 12px; }
+    .summary { color: #57606a; font-size: 12px; margin-bottom: 16px; }
+    table { width: 100%; border-collapse: collapse; }
+    th, td { text-align: left; padding: 8px 10px; border-bottom: 1px solid #eaeef2; }
+    th { cursor: pointer; user-select: none; color: #57606a; font-weight: 600; white-space: nowrap; }
+    th.sorted::after { content: ' \25be'; }
+    th.sorted.ascending::after { content: ' \25b4'; }
+    td.number { text-align: right; font-variant-numeric: tabular-nums; white-space: nowrap; }
+    th.number { text-align: right; }
+    .title { font-weight: 600; }
+    .url { color: #57606a; font-size: 12px; word-break: break-all; }
+    .state { color: #57606a; white-space: nowrap; }
+    .actions { white-space: nowrap; }
+    button { padding: 4px 8px; border: 1px solid #d0d7de; background: #fff; border-radius: 6px; cursor: pointer; }
+    button:disabled { cursor: default; opacity: 0.5; }
+  </style>
+</head>
+<body>
+  <h1>%1</h1>
+  <div id="summary" class="summary"></div>
+  <table>
+    <thead>
+      <tr>
+        <th data-key="title">%2</th>
+        <th data-key="pid" class="number">%3</th>
+        <th data-key="memory" class="number">%4</th>
+        <th data-key="cpu" class="number">%5</th>
+        <th data-key="cpuTime" class="number">%6</th>
+        <th data-key="state">%7</th>
+        <th></th>
+      </tr>
+    </thead>
+    <tbody id="tabs"></tbody>
+  </table>
+  <script>
+    const strings = %8;
+    const refreshInterval = %9;
+    const body = document.getElementById('tabs');
+    const summary = document.getElementById('summary');
+    let sortKey = 'memory';
+    let ascending = false;
+    let rows = [];
+
+    function request(method, url) {
+      return new Promise((resolve, reject) => {
+        const xhr = new XMLHttpRequest();
+        xhr.open(method, url);
+        xhr.responseType = 'json';
+        xhr.onload = () => resolve(xhr.response);
+        xhr.onerror = reject;
+        xhr.send();
+      });
+    }
+    // Markers are built at run time, QString::arg would replace them in this template.
+    function format(text, values) {
+      return values.reduce((result, value, i) => result.replace('%' + (i + 1), value), text);
+    }
+    // PSS shares memory out between the processes using it, so it is preferred where the kernel has it.
+    function memory(tab) {
+      return tab.pss >= 0 ? tab.pss : tab.rss;
+    }
+    function size(bytes) {
+      return bytes < 0 ? '–' : (bytes / 1048576).toFixed(1) + ' MB';
+    }
+    function duration(ms) {
+      return ms < 0 ? '–' : (ms / 1000).toFixed(1) + ' s';
+    }
+    function value(tab) {
+      switch (sortKey) {
+      case 'title':
+        return tab.title.toLowerCase();
+      case 'memory':
+        return memory(tab);
+      default:
+        return tab[sortKey];
+      }
+    }
+    function cell(text, className) {
+      const td = document.createElement('td');
+      if (className) {
+        td.className = className;
+      }
+      td.textContent = text;
+      return td;
+    }
+    function button(text, action, id, enabled) {
+      const b = document.createElement('button');
+      b.textContent = text;
+      b.disabled = !enabled;
+      b.addEventListener('click', async () => {
+        b.disabled = true;
+        await request('POST', 'mx-tasks://list/' + action + '?id=' + id);
+        refresh();
+      });
+      return b;
+    }
+    function render() {
+      const sorted = rows.slice().sort((a, b) => {
+        const x = value(a);
+        const y = value(b);
+        const order = x < y ? -1 : x > y ? 1 : a.id - b.id;
+        return ascending ? order : -order;
+      });
+      const fragment = document.createDocumentFragment();
+      sorted.forEach(tab => {
+        const tr = document.createElement('tr');
+        const title = cell('');
+        const name = document.createElement('div');
+        name.className = 'title';
+        name.textContent = tab.title;
+        const url = document.createElement('div');
+        url.className = 'url';
+        url.textContent = tab.url;
+        title.append(name, url);
+        const actions = cell('', 'actions');
+        actions.append(button(strings.discard, 'discard', tab.id, !tab.visible && tab.state !== 'discarded'), ' ',
+                       button(strings.close, 'close', tab.id, true));
+        tr.append(title, cell(tab.pid > 0 ? tab.pid : '–', 'number'), cell(size(memory(tab)), 'number'),
+                  cell(tab.cpuTime < 0 ? '–' : tab.cpu.toFixed(1) + ' %', 'number'),
+                  cell(duration(tab.cpuTime), 'number'), cell(strings[tab.state], 'state'), actions);
+        fragment.appendChild(tr);
+      });
+      body.replaceChildren(fragment);
+      document.querySelectorAll('th[data-key]').forEach(th => {
+        th.classList.toggle('sorted', th.dataset.key === sortKey);
+        th.classList.toggle('ascending', th.dataset.key === sortKey && ascending);
+      });
+    }
+    async function refresh() {
+      const data = await request('GET', 'mx-tasks://list/tabs');
+      rows = data.tabs;
+      summary.textContent = format(strings.summary, [data.queued, data.maxWait, data.freezes, data.discards]);
+      render();
+    }
+    document.querySelectorAll('th[data-key]').forEach(th => th.addEventListener('click', () => {
+      ascending = th.dataset.key === sortKey ? !ascending : th.dataset.key === 'title';
+      sortKey = th.dataset.key;
+      render();
+    }));
+    // Hidden pages do not poll, which lets the sampler stop.
+    setInterval(() => {
+      if (!document.hidden) {
+        refresh();
+      }
+    }, refreshInterval);
+    document.addEventListener('visibilitychange', () => {
+      if (!document.hidden) {
+        refresh();
+      }
+    });
+    refresh();
+  </script>
+</body>
+</html>)")
+                             .arg(QCoreApplication::translate("MainWindow", "Task manager").toHtmlEscaped(),
+                                  QCoreApplication::translate("MainWindow", "Tab").toHtmlEscaped(),
+                                  QCoreApplication::translate("MainWindow", "Process").toHtmlEscaped(),
+                                  QCoreApplication::translate("MainWindow", "Memory").toHtmlEscaped(),
+                                  QCoreApplication::translate("MainWindow", "CPU").toHtmlEscaped(),
+                                  QCoreApplication::translate("MainWindow", "CPU time").toHtmlEscaped(),
+                                  QCoreApplication::translate("MainWindow", "State").toHtmlEscaped(),
+                                  QString::fromUtf8(QJsonDocument(strings).toJson(QJsonDocument::Compact)),
+                                  QString::number(refreshInterval));
+    return html.toUtf8();
+}
@@ -0,0 +1,49 @@
+/*****************************************************************************
+ * tasksschemehandler.h
+ *****************************************************************************
+ * Copyright (C) 2026 MX Authors
+ *
+ * Authors: Adrian <adrian@mxlinux.org>
+ *          MX Linux <http://mxlinux.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MX Viewer is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MX Viewer.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#pragma once
+
+#include <QWebEngineUrlSchemeHandler>
+
+class QWebEngineUrlRequestJob;
+
+// Serves the task manager page. mx-tasks://list is the page, which polls
+// mx-tasks://list/tabs for the tabs of all windows with the memory and CPU
+// use of their renderers, and posts to /close and /discard with a tab id.
+class TasksSchemeHandler : public QWebEngineUrlSchemeHandler
+{
+    Q_OBJECT
+
+public:
+    explicit TasksSchemeHandler(QObject *parent = nullptr);
+
+    static void registerScheme();
+    void requestStarted(QWebEngineUrlRequestJob *job) override;
+
+private:
+    static constexpr int refreshInterval {2000};
+
+    static QByteArray pageHtml();
+    static QByteArray tabsJson();
+    static bool closeTab(int id);
+    static bool isOwnRequest(const QWebEngineUrlRequestJob *job);
+    static void reply(QWebEngineUrlRequestJob *job, const QByteArray &contentType, const QByteArray &data);
+};
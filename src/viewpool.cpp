@@ -0,0 +1,111 @@
+/*****************************************************************************
+ * viewpool.cpp
+ *****************************************************************************
+ * Copyright (C) 2026 MX Authors
+ *
+ * Authors: Adrian <adrian@mxlinux.org>
+ *          MX Linux <http://mxlinux.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MX Viewer is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MX Viewer.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#include "viewpool.h"
+#include "webview.h"
+
+#include <QCoreApplication>
+
+ViewPool::ViewPool(QObject *parent)
+    : QObject(parent)
+{
+    refillTimer.setSingleShot(true);
+    refillTimer.setInterval(refillDelay);
+    connect(&refillTimer, &QTimer::timeout, this, &ViewPool::refill);
+}
+
+ViewPool::~ViewPool()
+{
+    clear();
+}
+
+ViewPool *ViewPool::instance()
+{
+    static auto *pool = new ViewPool(QCoreApplication::instance());
+    return pool;
+}
+
+WebView *ViewPool::take(QWebEngineProfile *profile, const QUrl &url)
+{
+    if (profile != this->profile) {
+        clear();
+        this->profile = profile;
+    }
+    WebView *view {};
+    const bool wantsPreloaded = !url.isEmpty() && url == preloadUrl;
+    preloadWanted = preloadWanted || wantsPreloaded;
+    if (preloaded && wantsPreloaded) {
+        view = preloaded;
+        preloaded = nullptr;
+    } else if (blank) {
+        view = blank;
+        blank = nullptr;
+    } else {
+        view = new WebView(profile);
+    }
+    view->setSpare(false);
+    refillTimer.start();
+    return view;
+}
+
+// A spare with another page is of no use any more.
+void ViewPool::setPreloadUrl(const QUrl &url)
+{
+    if (url == preloadUrl) {
+        return;
+    }
+    preloadUrl = url;
+    preloadWanted = false;
+    delete preloaded;
+    if (profile) {
+        refillTimer.start();
+    }
+}
+
+// Drop the spares, e.g. before their profile goes away.
+void ViewPool::clear()
+{
+    refillTimer.stop();
+    delete blank;
+    delete preloaded;
+    profile = nullptr;
+}
+
+void ViewPool::refill()
+{
+    if (!profile) {
+        return;
+    }
+    if (!blank) {
+        blank = createSpare();
+    }
+    if (!preloaded && preloadWanted) {
+        preloaded = createSpare();
+        preloaded->setUrl(preloadUrl);
+    }
+}
+
+WebView *ViewPool::createSpare() const
+{
+    auto *view = new WebView(profile);
+    view->setSpare(true);
+    return view;
+}
@@ -0,0 +1,66 @@
+/*****************************************************************************
+ * viewpool.h
+ *****************************************************************************
+ * Copyright (C) 2026 MX Authors
+ *
+ * Authors: Adrian <adrian@mxlinux.org>
+ *          MX Linux <http://mxlinux.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MX Viewer is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MX Viewer.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#pragma once
+
+#include <QList>
+#include <QObject>
+#include <QPointer>
+#include <QTimer>
+#include <QUrl>
+
+class QWebEngineProfile;
+class WebView;
+
+// Spare views built ahead of time, so opening a tab does not wait for a view
+// and its page to be constructed. There is a blank spare and, once a tab was
+// opened with the preload URL (the home page for new tabs), one with that page
+// already loaded; a viewer only opened for one page never loads it. Spares
+// taken are replaced a moment later, off the path of the user action.
+class ViewPool : public QObject
+{
+    Q_OBJECT
+
+public:
+    static ViewPool *instance();
+    ~ViewPool() override;
+
+    // A view for profile; with the preload URL loaded if url is the preload URL and that spare is
+    // ready, otherwise blank.
+    [[nodiscard]] WebView *take(QWebEngineProfile *profile, const QUrl &url = {});
+    void setPreloadUrl(const QUrl &url);
+    void clear();
+
+private:
+    explicit ViewPool(QObject *parent = nullptr);
+
+    QPointer<QWebEngineProfile> profile;
+    QPointer<WebView> blank;
+    QPointer<WebView> preloaded;
+    QUrl preloadUrl;
+    bool preloadWanted {};
+    QTimer refillTimer;
+
+    static constexpr int refillDelay {1000};
+
+    void refill();
+    [[nodiscard]] WebView *createSpare() const;
+};
@@ -20,12 +20,16 @@
  * along with this package. If not, see <http://www.gnu.org/licenses/>.
  **********************************************************************/
 #include "webview.h"
+#include "faviconstore.h"
+#include "historystore.h"
 #include "mainwindow.h"
+#include "viewpool.h"
 
 #include <QApplication>
-#include <QBuffer>
+#include <QDataStream>
 #include <QMouseEvent>
 #include <QTimer>
+#include <QWebEngineHistory>
 #include <QWebEngineProfile>
 
 // Static member definitions
@@ -51,15 +55,6 @@ void WebPage::javaScriptConsoleMessage(JavaScriptConsoleMessageLevel level, cons
 bool WebPage::acceptNavigationRequest(const QUrl &url, NavigationType type, bool isMainFrame)
 {
     Q_UNUSED(isMainFrame);
-    if (url.scheme() == "mx-history") {
-        auto *mw = qobject_cast<MainWindow *>(m_webView->window());
-        if (!mw) {
-            mw = qobject_cast<MainWindow *>(QApplication::activeWindow());
-        }
-        if (mw && mw->handleHistoryRequest(url)) {
-            return false;
-        }
-    }
     if (url.scheme() == "mx-settings") {
         auto *mw = qobject_cast<MainWindow *>(m_webView->window());
         if (!mw) {
@@ -85,7 +80,6 @@ bool WebPage::acceptNavigationRequest(const QUrl &url, NavigationType type, bool
 
 WebView::WebView(QWebEngineProfile *profile, QWidget *parent)
     : QWebEngineView(profile, parent),
-      index(historyLog.value("History/size", 0).toInt()),
       profile(profile)
 {
     setPage(new WebPage(profile, this));
@@ -152,7 +146,7 @@ bool WebView::wasClickConsumed()
 
 WebView *WebView::createWindow(QWebEnginePage::WebWindowType type)
 {
-    auto *newView = new WebView(profile);
+    auto *newView = ViewPool::instance()->take(profile);
     if (type == QWebEnginePage::WebBrowserTab) {
         // Check if acceptNavigationRequest already handled this click
         bool background = !wasClickConsumed() && lastClickWasNewTabRequest();
@@ -167,14 +161,44 @@ WebView *WebView::createWindow(QWebEnginePage::WebWindowType type)
     return newView;
 }
 
+// A spare view may load a page before anyone sees it; the visit is recorded when it is taken.
+void WebView::setSpare(bool spare)
+{
+    const bool taken = this->spare && !spare;
+    this->spare = spare;
+    if (taken && !url().isEmpty() && !page()->isLoading()) {
+        handleLoadFinished(true);
+    }
+}
+
+// The back and forward list as a QWebEngineHistory stream.
+QByteArray WebView::saveHistory()
+{
+    QByteArray data;
+    QDataStream stream(&data, QIODevice::WriteOnly);
+    stream << *history();
+    return data;
+}
+
+// Navigates to the current entry of the restored list only; false if there was nothing to restore.
+bool WebView::restoreHistory(const QByteArray &data)
+{
+    if (data.isEmpty()) {
+        return false;
+    }
+    QDataStream stream(data);
+    stream >> *history();
+    return stream.status() == QDataStream::Ok && history()->count() > 0;
+}
+
 void WebView::handleLoadFinished(bool ok)
 {
-    if (!ok) {
+    if (!ok || spare) {
         return;
     }
     const QUrl loadedUrl = url();
     if (!loadedUrl.isValid() || loadedUrl.toString() == "about:blank" || loadedUrl.scheme() == "mx-history"
-        || loadedUrl.scheme() == "mx-settings") {
+        || loadedUrl.scheme() == "mx-settings" || loadedUrl.scheme() == "mx-tasks") {
         return;
     }
     QTimer::singleShot(750, this, [this, loadedUrl] {
@@ -184,14 +208,7 @@ void WebView::handleLoadFinished(bool ok)
         if (url() != loadedUrl) {
             return;
         }
-        index = historyLog.value("History/size", 0).toInt();
-        historyLog.beginWriteArray("History");
-        historyLog.setArrayIndex(index);
-        historyLog.setValue("title", title());
-        historyLog.setValue("url", loadedUrl.toString());
-        historyLog.endArray();
-        historyLog.setValue("History/size", index + 1);
-        lastHistoryIndex = index;
+        lastHistoryIndex = HistoryStore::instance()->recordVisit(loadedUrl.toString(), title());
         lastHistoryUrl = loadedUrl;
         handleIconChanged();
     });
@@ -205,14 +222,8 @@ void WebView::handleIconChanged()
     if (url() != lastHistoryUrl) {
         return;
     }
-    QPixmap iconPixmap = icon().pixmap(QSize(22, 22));
-    QByteArray iconByteArray;
-    QBuffer buffer(&iconByteArray);
-    if (buffer.open(QIODevice::WriteOnly)) {
-        iconPixmap.save(&buffer, "PNG");
+    const QByteArray iconRef = FaviconStore::instance()->add(icon(), lastHistoryUrl.host());
+    if (!iconRef.isEmpty()) {
+        HistoryStore::instance()->setIcon(lastHistoryIndex, iconRef);
     }
-    historyLog.beginWriteArray("History");
-    historyLog.setArrayIndex(lastHistoryIndex);
-    historyLog.setValue("icon", iconByteArray);
-    historyLog.endArray();
 }
@@ -21,7 +21,6 @@
  **********************************************************************/
 #pragma once
 
-#include <QSettings>
 #include <QUrl>
 #include <QWebEnginePage>
 #include <QWebEngineView>
@@ -50,6 +49,9 @@ class WebView : public QWebEngineView
 public:
     explicit WebView(QWebEngineProfile *profile, QWidget *parent = nullptr);
     WebView *createWindow(QWebEnginePage::WebWindowType type) override;
+    void setSpare(bool spare);
+    [[nodiscard]] QByteArray saveHistory();
+    bool restoreHistory(const QByteArray &data);
 
     static bool lastClickWasNewTabRequest();
     static bool consumeIfNewTabRequest();  // Check, mark consumed, and clear - returns true if was new tab request
@@ -68,9 +70,8 @@ signals:
     void newWebView(WebView *wv, bool makeCurrent);
 
 private:
-    QSettings historyLog;
-    int index;
     int lastHistoryIndex = -1;
+    bool spare = false;
     QUrl lastHistoryUrl;
     QWidget *m_currentProxy = nullptr;
     QWebEngineProfile *profile {};
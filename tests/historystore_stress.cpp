@@ -0,0 +1,247 @@
+/*****************************************************************************
+ * historystore_stress.cpp
+ *****************************************************************************
+ * Copyright (C) 2026 MX Authors
+ *
+ * Authors: Adrian <adrian@mxlinux.org>
+ *          MX Linux <http://mxlinux.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MX Viewer is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MX Viewer.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+
+// Several processes share one history store: writers record, revisit and
+// remove entries at the same time, and all of them visit a shared set of URLs.
+// Then fresh processes check that no entry or visit was lost or duplicated,
+// once with the index and once with the index rebuilt from the log. Any
+// warning counts as a failure.
+
+#include "historystore.h"
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QDirIterator>
+#include <QFile>
+#include <QHash>
+#include <QSet>
+#include <QTemporaryDir>
+
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <limits>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace
+{
+constexpr int writerCount {4};
+constexpr int entriesPerWriter {400};
+constexpr int flushEvery {50};
+constexpr int sharedCount {40};
+
+int warnings {};
+
+void countWarnings(QtMsgType type, const QMessageLogContext &context, const QString &message)
+{
+    if (type != QtDebugMsg && type != QtInfoMsg) {
+        ++warnings;
+    }
+    fprintf(stderr, "%s\n", qPrintable(qFormatLogMessage(type, context, message)));
+}
+
+QString urlFor(int writer, int n)
+{
+    return QStringLiteral("https://writer%1.example/page%2").arg(writer).arg(n);
+}
+
+QString sharedUrl(int n)
+{
+    return QStringLiteral("https://shared.example/page%1").arg(n);
+}
+
+// Every writer visits each shared URL this many times, spread over its run.
+int sharedVisits(int n)
+{
+    return 1 + n % 3;
+}
+
+bool isRevisited(int n)
+{
+    return n % 3 == 0;
+}
+
+bool isRemoved(int n)
+{
+    return n % 10 == 9;
+}
+
+// Flushing every few entries makes the writers take the file lock often and in turn.
+int runWriter(int argc, char *argv[], int writer)
+{
+    QCoreApplication app(argc, argv);
+    auto *store = HistoryStore::instance();
+    QList<int> ids;
+    for (int n = 0; n < entriesPerWriter; ++n) {
+        ids.append(store->recordVisit(urlFor(writer, n), QStringLiteral("Page %1").arg(n)));
+        // The writers start on the shared URLs at different points, so new entries and revisits race.
+        const int shared = (n + writer * sharedCount / writerCount) % sharedCount;
+        const int round = n / sharedCount;
+        if (round < sharedVisits(shared)) {
+            store->recordVisit(sharedUrl(shared), QStringLiteral("Shared %1").arg(shared));
+        }
+        if (n % flushEvery == flushEvery - 1) {
+            store->flush();
+            QCoreApplication::processEvents();
+        }
+    }
+    for (int n = 0; n < entriesPerWriter; ++n) {
+        if (isRevisited(n)) {
+            store->recordVisit(urlFor(writer, n), {});
+        }
+        if (isRemoved(n) && !store->remove(ids.at(n))) {
+            qWarning() << "Could not remove" << urlFor(writer, n);
+        }
+    }
+    store->flush();
+    QCoreApplication::processEvents();
+    return warnings == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+int runVerifier(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    const auto *store = HistoryStore::instance();
+    QHash<QString, HistoryEntry> byUrl;
+    QSet<int> seen;
+    for (const int id : store->recentIds({}, std::numeric_limits<int>::max())) {
+        const HistoryEntry entry = store->entry(id);
+        if (seen.contains(id) || !entry.isValid() || entry.id != id) {
+            qWarning() << "Entry listed twice or unreadable:" << id;
+            continue;
+        }
+        seen.insert(id);
+        if (byUrl.contains(entry.url)) {
+            qWarning() << "Duplicate entries for" << entry.url << byUrl.value(entry.url).id << id;
+        }
+        byUrl.insert(entry.url, entry);
+    }
+    qsizetype expected {};
+    for (int writer = 0; writer < writerCount; ++writer) {
+        for (int n = 0; n < entriesPerWriter; ++n) {
+            const QString url = urlFor(writer, n);
+            if (isRemoved(n)) {
+                if (byUrl.contains(url)) {
+                    qWarning() << "Removed entry came back:" << url;
+                }
+                continue;
+            }
+            ++expected;
+            const int visits = isRevisited(n) ? 2 : 1;
+            if (!byUrl.contains(url)) {
+                qWarning() << "Lost entry:" << url;
+            } else if (byUrl.value(url).visitCount != visits) {
+                qWarning() << "Wrong visit count for" << url << byUrl.value(url).visitCount << "instead of" << visits;
+            }
+        }
+    }
+    // Each shared URL has a single entry holding the visits of every writer.
+    for (int n = 0; n < sharedCount; ++n) {
+        const QString url = sharedUrl(n);
+        ++expected;
+        const int visits = writerCount * sharedVisits(n);
+        if (!byUrl.contains(url)) {
+            qWarning() << "Lost entry:" << url;
+        } else if (byUrl.value(url).visitCount != visits) {
+            qWarning() << "Lost visits for" << url << byUrl.value(url).visitCount << "instead of" << visits;
+        }
+    }
+    if (byUrl.size() != expected) {
+        qWarning() << byUrl.size() << "entries instead of" << expected;
+    }
+    // Read on its own, the log must hold the same entries the index points to.
+    qsizetype logged {};
+    HistoryStore::forEachEntry(store->snapshot(), [&byUrl, &logged](const HistoryEntry &entry) {
+        ++logged;
+        if (byUrl.value(entry.url).id != entry.id) {
+            qWarning() << "Log and index disagree on" << entry.url;
+        }
+    });
+    if (logged != expected) {
+        qWarning() << logged << "entries in the log instead of" << expected;
+    }
+    return warnings == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+// No QCoreApplication exists in this process, so children start from a clean state.
+pid_t spawn(const std::function<int()> &run)
+{
+    const pid_t pid = fork();
+    if (pid == 0) {
+        _exit(run());
+    }
+    if (pid < 0) {
+        qWarning() << "Could not fork";
+    }
+    return pid;
+}
+
+bool waitFor(const QList<pid_t> &children)
+{
+    bool ok = true;
+    for (const pid_t pid : children) {
+        int status {};
+        if (pid < 0 || waitpid(pid, &status, 0) != pid || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+            ok = false;
+        }
+    }
+    return ok;
+}
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    qInstallMessageHandler(countWarnings);
+    QTemporaryDir dir;
+    if (!dir.isValid()) {
+        qWarning() << "Could not create a temporary directory";
+        return EXIT_FAILURE;
+    }
+    for (const char *name : {"XDG_DATA_HOME", "XDG_CONFIG_HOME", "XDG_CACHE_HOME"}) {
+        qputenv(name, QFile::encodeName(dir.filePath(QString::fromLatin1(name))));
+    }
+    QCoreApplication::setOrganizationName("MX-Linux");
+
+    QList<pid_t> writers;
+    for (int writer = 0; writer < writerCount; ++writer) {
+        writers.append(spawn([argc, argv, writer] { return runWriter(argc, argv, writer); }));
+    }
+    if (!waitFor(writers)) {
+        qWarning() << "A writer failed";
+        return EXIT_FAILURE;
+    }
+    if (!waitFor({spawn([argc, argv] { return runVerifier(argc, argv); })})) {
+        qWarning() << "Verification with the index failed";
+        return EXIT_FAILURE;
+    }
+    QDirIterator it(dir.path(), {"history.idx"}, QDir::Files, QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        QFile::remove(it.next());
+    }
+    if (!waitFor({spawn([argc, argv] { return runVerifier(argc, argv); })})) {
+        qWarning() << "Verification with a rebuilt index failed";
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,92 @@
+/*****************************************************************************
+ * tabswitch_benchmark.cpp
+ *****************************************************************************
+ * Copyright (C) 2026 MX Authors
+ *
+ * Authors: Adrian <adrian@mxlinux.org>
+ *          MX Linux <http://mxlinux.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MX Viewer is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MX Viewer.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+
+// Times tab switches in a main window as the number of open tabs grows. The
+// time per switch should stay flat. Runs on the offscreen platform unless
+// QT_QPA_PLATFORM says otherwise, with the settings and data of a temporary
+// directory so no saved session gets in the way.
+
+#include "historyschemehandler.h"
+#include "mainwindow.h"
+#include "tasksschemehandler.h"
+
+#include <QApplication>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QTabWidget>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QUrl>
+
+#include <cstdlib>
+
+namespace
+{
+constexpr int tabCounts[] {10, 40, 160};
+constexpr int switches {400};
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QTemporaryDir dir;
+    if (!dir.isValid()) {
+        qWarning() << "Could not create a temporary directory";
+        return EXIT_FAILURE;
+    }
+    for (const char *name : {"XDG_DATA_HOME", "XDG_CONFIG_HOME", "XDG_CACHE_HOME"}) {
+        qputenv(name, QFile::encodeName(dir.filePath(QString::fromLatin1(name))));
+    }
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    HistorySchemeHandler::registerScheme();
+    TasksSchemeHandler::registerScheme();
+    QApplication app(argc, argv);
+    QApplication::setOrganizationName("MX-Linux");
+
+    auto *window = new MainWindow(QUrl("about:blank"));
+    window->show();
+    auto *tabs = window->findChild<QTabWidget *>();
+    if (!tabs) {
+        qWarning() << "No tab widget in the main window";
+        return EXIT_FAILURE;
+    }
+
+    QTextStream out(stdout);
+    out << "tabs\tus per switch\n";
+    for (const int count : tabCounts) {
+        while (tabs->count() < count) {
+            window->openUrl("about:blank");
+        }
+        QApplication::processEvents();
+        QElapsedTimer timer;
+        timer.start();
+        for (int i = 0; i < switches; ++i) {
+            tabs->setCurrentIndex((tabs->currentIndex() + 1) % tabs->count());
+        }
+        out << tabs->count() << '\t' << timer.nsecsElapsed() / 1000 / switches << '\n';
+        out.flush();
+    }
+    window->close();
+    return EXIT_SUCCESS;
+}